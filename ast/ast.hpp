@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ast/annotation.hpp"
+#include "ast/astarena.hpp"
 #include "ast/expressionvisitor.hpp"
 #include "ast/statementvisitor.hpp"
 #include "common/token.hpp"
@@ -42,6 +43,10 @@ namespace kvantum {
 
 struct FunctionNode;
 
+/*
+    AST nodes are owned by the AstArena of their module and must be created with make_node,
+    they never delete their children
+*/
 class AST_Node
 {
 public:
@@ -109,12 +114,6 @@ public:
         this->parenthesised = parenthesized;
     }
 
-    ~BinaryOperation()
-    {
-        delete lhs;
-        delete rhs;
-    }
-
     Type &getType() override
     {
         if (isBool())
@@ -124,7 +123,10 @@ public:
         return rhs->getType();
     }
 
-    BinaryOperation *copy() override { return new BinaryOperation(lhs->copy(), rhs->copy(), op); }
+    BinaryOperation *copy() override
+    {
+        return make_node<BinaryOperation>(lhs->copy(), rhs->copy(), op);
+    }
     constexpr bool isBool() { return op >= EQUAL; }
     constexpr bool isParenthesized() const { return parenthesised; }
 
@@ -147,10 +149,12 @@ public:
 
     Type &getType() override { return type; }
 
-    Literal *copy() override { return new Literal(value, type); }
+    Literal *copy() override { return make_node<Literal>(value, type); }
 
     string value;
     Type &type;
+    ///index of the decoded value in the interpreter constant pools, given on the first lookup
+    uint32_t constant = UINT32_MAX;
 };
 
 class FieldAccess;
@@ -164,6 +168,15 @@ public:
         , type(&t)
     {
         id = i;
+        symbol = SymbolTable::intern(id);
+    }
+    ///for names that were already interned by the lexer
+    Variable(SymbolID sym, Type &t = Type::get("Void"))
+        : Expression(ExprType::VARIABLE)
+        , type(&t)
+    {
+        id = SymbolTable::getName(sym);
+        symbol = sym;
     }
 
     Type &getType() override { return *type; }
@@ -173,10 +186,15 @@ public:
 
     virtual bool isField() { return false; }
     FieldAccess *asField();
-    Variable *copy() override { return new Variable(id, *type); }
+    Variable *copy() override { return make_node<Variable>(symbol, *type); }
+
+    static constexpr uint16_t NO_SLOT = UINT16_MAX;
 
     string id;
+    SymbolID symbol;
     Type *type;
+    ///frame slot of the local or parameter, set by the interpreter's slot resolver
+    uint16_t slot = NO_SLOT;
 };
 
 class FieldAccess : public Variable
@@ -189,17 +207,11 @@ public:
         field = f;
     }
 
-    ~FieldAccess()
-    {
-        delete base;
-        delete field;
-    }
-
     Type &getType() override { return field->getType(); }
     bool isField() override { return true; }
     Variable *end() override { return field->end(); }
 
-    FieldAccess *copy() override { return new FieldAccess(base->copy(), field->copy()); }
+    FieldAccess *copy() override { return make_node<FieldAccess>(base->copy(), field->copy()); }
     Expression *base;
     Variable *field;
 };
@@ -212,12 +224,12 @@ public:
         : Expression(ExprType::DYNAMIC_ALLOCATION)
         , node(n)
     {
-        sizeExpr = new Literal(std::to_string(node.getAllocSize()), Type::get("Int"));
+        sizeExpr = make_node<Literal>(std::to_string(node.getAllocSize()), Type::get("Int"));
     }
 
     Type &getType() override { return ReferenceType::get(node); }
 
-    DynamicAllocation *copy() override { return new DynamicAllocation(node); }
+    DynamicAllocation *copy() override { return make_node<DynamicAllocation>(node); }
     virtual Expression *getSizeExpr() { return sizeExpr; }
 
     Expression *sizeExpr;
@@ -237,7 +249,7 @@ public:
     Type &getType() override { return type; }
     ArrayExpression *copy() override
     {
-        return new ArrayExpression(type,
+        return make_node<ArrayExpression>(type,
                                    apply(initializer.begin(),
                                          initializer.end(),
                                          std::function([](Literal *l) { return l->copy(); })));
@@ -254,14 +266,16 @@ public:
         : DynamicAllocation(itemT)
         , itemType(itemT)
     {
-        itemType = itemT;
         sizeVar = sizeV;
-        sizeExpr = new BinaryOperation(sizeExpr, sizeVar, BinaryOperation::MULTIPLY);
+        sizeExpr = make_node<BinaryOperation>(sizeExpr, sizeVar, BinaryOperation::MULTIPLY);
     }
 
     Type &getType() override { return node; }
 
-    ArrayAllocation *copy() override { return new ArrayAllocation(itemType, sizeVar->copy()); }
+    ArrayAllocation *copy() override
+    {
+        return make_node<ArrayAllocation>(itemType, sizeVar->copy());
+    }
     Expression *getSizeExpr() override { return sizeExpr; }
 
     Type &itemType;
@@ -280,7 +294,7 @@ public:
     }
 
     Type &getType() override { return baseArray->getType().asArray().getType(); }
-    ArrayIndex *copy() override { return new ArrayIndex(baseArray->copy(), index->copy()); }
+    ArrayIndex *copy() override { return make_node<ArrayIndex>(baseArray->copy(), index->copy()); }
 
     Expression *baseArray;
     Expression *index;
@@ -295,7 +309,7 @@ public:
         , baseExpr(expr)
     {}
     Type &getType() override { return ReferenceType::get(baseExpr->getType()); }
-    TakeReference *copy() override { return new TakeReference(baseExpr->copy()); }
+    TakeReference *copy() override { return make_node<TakeReference>(baseExpr->copy()); }
 
     Expression *baseExpr;
 };
@@ -311,7 +325,7 @@ public:
         this->expr = expr;
     }
     Type &getType() override { return castTo; }
-    Cast *copy() override { return new Cast(expr->copy(), castTo); }
+    Cast *copy() override { return make_node<Cast>(expr->copy(), castTo); }
 
     Expression *expr;
     Type &castTo;
@@ -337,14 +351,9 @@ public:
     StatementBlock()
         : Statement(StatementType::BLOCK)
     {}
-    ~StatementBlock()
-    {
-        for (auto &e : block)
-            delete e;
-    }
     StatementBlock *copy() override
     {
-        StatementBlock *b = new StatementBlock();
+        StatementBlock *b = make_node<StatementBlock>();
         b->block = apply(block.begin(), block.end(), std::function([](Statement *s) {
                              return s->copy();
                          }));
@@ -366,14 +375,9 @@ public:
         declaration = decl;
     }
 
-    ~Assigment() override
-    {
-        delete variable;
-        delete expr;
-    }
     Assigment *copy() override
     {
-        return new Assigment(variable->copy(), expr->copy(), declaration);
+        return make_node<Assigment>(variable->copy(), expr->copy(), declaration);
     }
     bool isDeclaration() const { return declaration; }
     Assigment *setDeclaration(bool decl)
@@ -398,8 +402,7 @@ public:
     {
         expr = e;
     }
-    ~Return() override { delete expr; }
-    Return *copy() override { return new Return(expr->copy()); }
+    Return *copy() override { return make_node<Return>(expr->copy()); }
 
     Expression *expr;
 };
@@ -416,15 +419,9 @@ public:
         elseBlock = elseb;
     }
 
-    ~If_Else() override
-    {
-        delete condition;
-        delete ifBlock;
-        delete elseBlock;
-    }
     If_Else *copy() override
     {
-        return new If_Else(condition->copy(), ifBlock->copy(), elseBlock->copy());
+        return make_node<If_Else>(condition->copy(), ifBlock->copy(), elseBlock->copy());
     }
 
     Expression *condition;
@@ -442,12 +439,7 @@ public:
         condition = cond;
         block = b;
     }
-    ~While() override
-    {
-        delete condition;
-        delete block;
-    }
-    While *copy() override { return new While(condition->copy(), block->copy()); }
+    While *copy() override { return make_node<While>(condition->copy(), block->copy()); }
 
     Expression *condition;
     Statement *block;
@@ -481,18 +473,11 @@ public:
         fnode = node;
     }
 
-    ~FunctionCall() override
-    {
-        delete var;
-        for (auto &e : arguments)
-            delete e;
-    }
-
     void setNode(FunctionNode *node) { fnode = node; }
     Type &getType() override;
     FunctionCall *copy() override
     {
-        return new FunctionCall(var->copy(),
+        return make_node<FunctionCall>(var->copy(),
                                 apply(arguments.begin(),
                                       arguments.end(),
                                       std::function([](Expression *e) { return e->copy(); })));
@@ -500,5 +485,7 @@ public:
     FunctionNode *fnode;
     Variable *var;
     vector<Expression *> arguments;
+    ///index of the call site cache in the tree walking interpreter, given on the first call
+    uint32_t callSite = UINT32_MAX;
 };
 } // namespace kvantum
@@ -0,0 +1,45 @@
+#include "ast/astarena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace kvantum {
+
+void AstArena::reset()
+{
+    for (auto iter = destructors.rbegin(); iter != destructors.rend(); iter++)
+        iter->second(iter->first);
+    destructors.clear();
+    chunks.clear();
+    cursor = limit = nullptr;
+    allocated = 0;
+}
+
+AstArena &AstArena::global()
+{
+    static AstArena arena;
+    return arena;
+}
+
+void *AstArena::allocate(size_t size, size_t align)
+{
+    auto aligned = [align](char *p) {
+        return reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(p) + align - 1) & ~(align - 1));
+    };
+
+    char *mem = cursor ? aligned(cursor) : nullptr;
+    if (!mem || mem + size > limit) {
+        ///oversized nodes get a chunk of their own
+        size_t chunkSize = std::max(CHUNK_SIZE, size + align);
+        chunks.push_back(unique_ptr<char[]>(new char[chunkSize]));
+        cursor = chunks.back().get();
+        limit = cursor + chunkSize;
+        mem = aligned(cursor);
+    }
+    cursor = mem + size;
+    allocated += size;
+    return mem;
+}
+
+thread_local AstArena *AstArena::active = nullptr;
+
+} // namespace kvantum
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using std::unique_ptr;
+using std::vector;
+
+namespace kvantum {
+
+/*
+    bump pointer allocator which owns the AST nodes of a module
+    nodes are packed into large chunks and are never freed one by one,
+    resetting the arena destroys every node at once
+*/
+class AstArena
+{
+public:
+    AstArena() = default;
+    ~AstArena() { reset(); }
+    AstArena(const AstArena &) = delete;
+    AstArena &operator=(const AstArena &) = delete;
+
+    template<typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        T *node = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            destructors.push_back({node, [](void *p) { static_cast<T *>(p)->~T(); }});
+        return node;
+    }
+
+    /// destroys every node in reverse creation order and releases the chunks
+    void reset();
+    size_t getAllocatedSize() const { return allocated; }
+
+    /*
+        makes the arena the target of make_node on this thread until the activation goes out of scope
+    */
+    class Activation
+    {
+    public:
+        explicit Activation(AstArena &arena)
+            : previous(active)
+        {
+            active = &arena;
+        }
+        ~Activation() { active = previous; }
+
+    private:
+        AstArena *previous;
+    };
+
+    /// the arena activated on this thread or the global arena if there is none
+    static AstArena &current() { return active ? *active : global(); }
+    /// owns nodes that are shared between modules, it lives until the end of the process
+    static AstArena &global();
+
+private:
+    void *allocate(size_t size, size_t align);
+
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    vector<unique_ptr<char[]>> chunks;
+    char *cursor = nullptr;
+    char *limit = nullptr;
+    size_t allocated = 0;
+    vector<std::pair<void *, void (*)(void *)>> destructors;
+
+    static thread_local AstArena *active;
+};
+
+/// creates an AST node in the current arena
+template<typename T, typename... Args>
+T *make_node(Args &&...args)
+{
+    return AstArena::current().create<T>(std::forward<Args>(args)...);
+}
+
+} // namespace kvantum
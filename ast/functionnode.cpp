@@ -7,14 +7,16 @@ FunctionNode::FunctionIdentifier::FunctionIdentifier(FunctionCall* fcall)
 {
     if (fcall->var->isField()) {
         auto fa = fcall->var->as<FieldAccess*>();
-        name = fa->base->as<Variable*>()->id;
-        parentObj = fa->field->id;
+        ///the method is the field, the object or type it is called on is the base
+        name = fa->field->id;
+        symbol = fa->field->symbol;
+        parentObj = fa->base->as<Variable*>()->id;
     }
 }
 
 string FunctionNode::FunctionIdentifier::createName() const
 {
-    string name = parent != Type::get("Void") ? parent.getName() + "_" : "";
+    string name = *parent != Type::get("Void") ? parent->getName() + "_" : "";
     name += this->name;
     for (auto& e : params)
         name += "_" + e->getName();
@@ -23,7 +25,9 @@ string FunctionNode::FunctionIdentifier::createName() const
 
 bool FunctionNode::FunctionIdentifier::operator==(const FunctionIdentifier& other) const
 {
-    bool eq = this->name == other.name && this->params.size() == other.params.size();
+    ///static methods of different types can share the parameters, the type tells them apart
+    bool eq = this->symbol == other.symbol && *this->parent == *other.parent
+              && this->params.size() == other.params.size();
     int i = 0;
     while (eq && i < this->params.size() && this->params[i] == other.params[i]) {
         i++;
@@ -31,4 +35,12 @@ bool FunctionNode::FunctionIdentifier::operator==(const FunctionIdentifier& othe
     return i == this->params.size() && eq;
 }
 
+size_t FunctionNode::FunctionIdentifier::hash() const
+{
+    size_t h = std::hash<SymbolID>()(symbol);
+    for (auto& e : params)
+        h = h * 31 + std::hash<Type*>()(e);
+    return h;
+}
+
 } // namespace kvantum
@@ -2,6 +2,7 @@
 #define FUNCTIONNODE_HPP
 
 #include "ast.hpp"
+#include <optional>
 
 namespace kvantum {
 
@@ -12,12 +13,14 @@ struct FunctionNode
         FunctionIdentifier(string nm, vector<Expression *> args = {}, string p = "")
             : parentObj(std::move(p))
             , name(std::move(nm))
+            , symbol(SymbolTable::intern(name))
             , params(apply(ITER_THROUGH(args),
                            std::function([](Expression *e) -> Type * { return &e->getType(); })))
         {}
-        FunctionIdentifier(string nm, vector<Variable *> args, string p = "")
+        FunctionIdentifier(SymbolID nm, vector<Variable *> args, string p = "")
             : parentObj(std::move(p))
-            , name(std::move(nm))
+            , name(SymbolTable::getName(nm))
+            , symbol(nm)
             , params(apply(ITER_THROUGH(args),
                            std::function([](Variable *e) -> Type * { return &e->getType(); })))
         {}
@@ -25,10 +28,12 @@ struct FunctionNode
         FunctionIdentifier(FunctionCall *fcall);
 
         bool isField() const { return !parentObj.empty(); }
-        Type &getBaseType() const { return parent; }
-        void setBaseType(Type &t) { parent = t; }
+        Type &getBaseType() const { return *parent; }
+        void setBaseType(Type &t) { parent = &t; }
         string createName() const;
         bool operator==(const FunctionIdentifier &other) const;
+        ///consistent with ==, the name symbol combined with the parameter types
+        size_t hash() const;
 
         string getArgumentListStr() const
         {
@@ -42,13 +47,16 @@ struct FunctionNode
 
         string parentObj;
         string name;
+        SymbolID symbol;
         vector<Type *> params;
-        Type &parent = Type::get("Void");
+        Type *parent = &Type::get("Void");
     };
 
     FunctionIdentifier getFunctionID() const
     {
-        return {name, formalParams, *parent != Type::get("Void") ? parent->getName() : ""};
+        FunctionIdentifier id(symbol, formalParams, *parent != Type::get("Void") ? parent->getName() : "");
+        id.setBaseType(*parent);
+        return id;
     }
 
     enum Trait {
@@ -57,11 +65,18 @@ struct FunctionNode
         STATIC = 0b00000100,
         VIRTUAL = 0b00001000,
         OVERRIDE = 0b00010000,
-        EXPLICIT_TYPE = 0b00100000
+        EXPLICIT_TYPE = 0b00100000,
+        ///defined as fn f(...) => expr;
+        EXPRESSION = 0b01000000,
+        ///declared [external], implemented natively where the backend has a builtin of the name
+        EXTERNAL = 0b10000000
     };
 
+    ///changed only through addParameter, the mangled name is cached from it
     vector<Variable *> formalParams;
     vector<Statement *> ast;
+    ///frame slots needed by the parameters and locals, set once the slots are resolved
+    std::optional<uint16_t> frameSize;
 
     FunctionNode(string ids,
                  Type &retT = Type::get("Void"),
@@ -70,6 +85,7 @@ struct FunctionNode
                  Type &p = Type::get("Void"),
                  unsigned char tr = 0)
         : name(ids)
+        , symbol(SymbolTable::intern(name))
         , returnType(&retT)
         , formalParams(std::move(formal))
         , ast(body)
@@ -77,28 +93,41 @@ struct FunctionNode
         , traits(tr)
     {}
 
-    ~FunctionNode()
-    {
-        for (auto &e : formalParams)
-            delete e;
-        for (auto &e : ast)
-            delete e;
-    }
-
     void setTrait(Trait t) { traits |= t; }
     void setTraitList(unsigned char t) { traits = t; }
     bool hasTrait(Trait t) const { return traits & t; }
     unsigned int getTraits() const { return traits; }
 
-    void setName(string nm) { name = std::move(nm); }
+    void setName(string nm)
+    {
+        name = std::move(nm);
+        symbol = SymbolTable::intern(name);
+        id.reset();
+    }
     string getName() const { return name; }
-    string getID() const { return getFunctionID().createName(); }
+    SymbolID getSymbol() const { return symbol; }
+    void addParameter(Variable *param, bool first = false)
+    {
+        formalParams.insert(first ? formalParams.begin() : formalParams.end(), param);
+        id.reset();
+    }
+    ///the mangled name, built by the first call, which must not race with another
+    const string &getID() const
+    {
+        if (!id)
+            id = getFunctionID().createName();
+        return *id;
+    }
 
     void setReturnType(Type &t) { returnType = &t; }
     Type &getReturnType() const { return *returnType; }
 
     bool isMethod() const { return *parent != Type::get("Void"); }
-    void makeMethod(Type &t) { parent = &t; }
+    void makeMethod(Type &t)
+    {
+        parent = &t;
+        id.reset();
+    }
     Type &getParent() const { return *parent; }
 
     void setAnnotation(Annotation *an) { annotation = an; }
@@ -120,9 +149,11 @@ struct FunctionNode
 private:
     unsigned char traits = 0;
     string name;
+    SymbolID symbol;
     Type *parent = &Type::get("Void");
     Type *returnType = &Type::get("Void");
     Annotation *annotation = nullptr;
+    mutable std::optional<string> id;
 };
 
 } // namespace kvantum
@@ -1,12 +1,13 @@
 #pragma once
 #include "c_type.hpp"
+#include "c_writer.hpp"
 
-#include <iostream>
 namespace c::ast
 {
+   ///nodes write themselves straight into the sink, so nesting never copies the text of the children
    struct Expression
    {
-      virtual string getStr() = 0;
+      virtual void write(Writer& out) = 0;
       virtual Type* getType() = 0;
    };
 
@@ -18,9 +19,9 @@ namespace c::ast
          type = t;
       }
 
-      string getStr() override
+      void write(Writer& out) override
       {
-         return value;
+         out << value;
       }
 
       Type* getType()
@@ -40,9 +41,9 @@ namespace c::ast
          type = t;
       }
 
-      string getStr() override
+      void write(Writer& out) override
       {
-         return name;
+         out << name;
       }
 
       Type* getType()
@@ -62,9 +63,11 @@ namespace c::ast
            field = f;
        }
 
-       string getStr() override
+       void write(Writer& out) override
        {
-           return base->getStr() + (base->getType()->isPtr() ? "->" : ".") + field->getStr();
+           base->write(out);
+           out << (base->getType()->isPtr() ? "->" : ".");
+           field->write(out);
        }
 
        Type* getType()
@@ -84,9 +87,11 @@ namespace c::ast
          rhs = r;
       }
 
-      string getStr() override
+      void write(Writer& out) override
       {
-         return lhs->getStr() + operand + rhs->getStr();
+         lhs->write(out);
+         out << operand;
+         rhs->write(out);
       }
 
       Type* getType()
@@ -105,15 +110,15 @@ namespace c::ast
    {
        ArrayExpression(vector<Literal*> init) : initializer(init){}
 
-       string getStr() override
+       void write(Writer& out) override
        {
-           string str = "";
-           for (auto& e : initializer)
-               str += e->getStr() + ",";
-           if (!str.empty())
-               str.pop_back();
-
-           return "{" + str + "}";
+           out << '{';
+           for (size_t i = 0; i < initializer.size(); i++) {
+               if (i)
+                   out << ',';
+               initializer[i]->write(out);
+           }
+           out << '}';
        }
 
        Type* getType() override
@@ -137,9 +142,12 @@ namespace c::ast
            index = ind;
        }
 
-       string getStr() override
+       void write(Writer& out) override
        {
-           return arrayExpr->getStr() + "[" + index->getStr() + "]";
+           arrayExpr->write(out);
+           out << '[';
+           index->write(out);
+           out << ']';
        }
 
        Type* getType() override
@@ -153,20 +161,20 @@ namespace c::ast
 
    struct Statement
    {
-      virtual string getStr() = 0;
+      virtual void write(Writer& out) = 0;
    };
    struct Block : public Statement
    {
       vector<Statement*> statements;
 
-      string getStr() override
+      void write(Writer& out) override
       {
-         string str = "{\n";
+         out << "{\n";
          for(auto &e : statements){
-            str += e->getStr() + ";\n";
+            e->write(out);
+            out << ";\n";
          }
-         str += "}\n";
-         return str;
+         out << "}\n";
       }
 
       void insert(Statement* s)
@@ -184,7 +192,15 @@ namespace c::ast
          this->decl = decl;
       }
 
-      string getStr() override {return (decl ? var->getType()->getStr() : string("")) + string(" ") + var->getStr() + " = " + expr->getStr(); }
+      void write(Writer& out) override
+      {
+         if(decl)
+            out << var->getType()->getStr();
+         out << ' ';
+         var->write(out);
+         out << " = ";
+         expr->write(out);
+      }
 
       Variable* var;
       Expression* expr;
@@ -197,14 +213,18 @@ namespace c::ast
       {
          var = v;
       }
-      string getStr() override { return var->type->getStr() + string(" ") +var->name; }
+      void write(Writer& out) override { out << var->type->getStr() << ' ' << var->name; }
       Variable* var;
    };
 
    struct Return : public Statement
    {
       Return(Expression* e){ expr = e; }
-      string getStr() override { return "return " + expr->getStr(); }
+      void write(Writer& out) override
+      {
+         out << "return ";
+         expr->write(out);
+      }
 
       Expression* expr;
    };
@@ -218,10 +238,16 @@ namespace c::ast
          this->elseb = elseb;
       }
 
-      string getStr() override 
+      void write(Writer& out) override
       {
-         string r = "if(" + condition->getStr()+")" + "\n" + ifb->getStr() 
-            + (elseb ? elseb->getStr() : "");
+         out << "if(";
+         condition->write(out);
+         out << ")\n";
+         ifb->write(out);
+         if(elseb){
+            out << "else\n";
+            elseb->write(out);
+         }
       }
 
       Expression* condition;
@@ -231,6 +257,9 @@ namespace c::ast
 
    struct Function
    {
+      ///static functions are only visible in their translation unit
+      enum Linkage { EXTERNAL, STATIC, STATIC_INLINE };
+
       Function(string name,Type* ret = Type::getVoid(),bool variadric = false)
       {
          this->name = name;
@@ -239,25 +268,38 @@ namespace c::ast
          this->variadric = variadric;
       }
 
-      string getHeader()
+      void writeHeader(Writer& out)
       {
-         string str = returnType->getStr() + " " +name + "(";
-         for(auto &e : formalParams)
-            str += e->type->getStr() + " " + e->name + ",";
-         if(!formalParams.empty())
-            str.pop_back();
-         str += ")";
-         return str;
+         if(linkage != EXTERNAL)
+            out << (linkage == STATIC ? "static " : "static inline ");
+         out << returnType->getStr() << ' ' << name << '(';
+         for(size_t i = 0; i < formalParams.size(); i++){
+            if(i)
+               out << ',';
+            out << formalParams[i]->type->getStr() << ' ' << formalParams[i]->name;
+         }
+         out << ')';
       }
 
-      string getPrototype() { return getHeader() + ";"; }
-      string getDefiniton(){ return getHeader() + "\n" + block->getStr(); }
+      void writePrototype(Writer& out)
+      {
+         writeHeader(out);
+         out << ';';
+      }
+
+      void writeDefinition(Writer& out)
+      {
+         writeHeader(out);
+         out << '\n';
+         block->write(out);
+      }
 
       string name;
       vector<Variable*> formalParams;
       Block* block;
       Type* returnType;
       bool variadric;
+      Linkage linkage = EXTERNAL;
    };
 
    struct Struct 
@@ -266,12 +308,12 @@ namespace c::ast
       string getHeader() { return "struct " + name; }
       string getPrototype(){ return getHeader() + ";"; }
 
-      string getDefinition()
+      void writeDefinition(Writer& out)
       {
-         string str = getHeader() + "\n{\n";
+         out << getHeader() << "\n{\n";
          for(auto &e : fields)
-            str += e->type->getStr() + " " + e->getStr() + ";\n";
-         return str+"};\n";
+            out << e->type->getStr() << ' ' << e->name << ";\n";
+         out << "};\n";
       }
 
       string name;
@@ -286,15 +328,15 @@ namespace c::ast
          this->func = func;
       }
 
-      string getStr() override
+      void write(Writer& out) override
       {
-         string str = func->name + "(";
-         for(auto &e : arguments)
-            str += e->getStr() + ",";
-         if(!arguments.empty())
-            str.pop_back();
-         str += ")";
-         return str;
+         out << func->name << '(';
+         for(size_t i = 0; i < arguments.size(); i++){
+            if(i)
+               out << ',';
+            arguments[i]->write(out);
+         }
+         out << ')';
       }
 
       Type* getType()
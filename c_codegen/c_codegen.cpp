@@ -1,15 +1,43 @@
 #include "c_codegen/c_codegen.hpp"
+#include <cstdio>
+#include <iterator>
 
 namespace c::codegen {
 void CodeGenerator::setModule(string name)
 {
+    if (unity)
+        return;
     modules.push_back(new Module(name));
     currentModule()->addDependency(modules[0]);
 }
 
+void CodeGenerator::setUnity(string program)
+{
+    setModule(program);
+    unity = true;
+}
+
+///declarations are deduplicated, in a unity build the imports of a module are already defined in it
 void CodeGenerator::functionPrototype(string name, Type* returnt, vector<Variable*> args)
 {
-    currentModule()->functions.push_back(new Function(name));
+    if (!currentModule()->getFunction(name))
+        currentModule()->addFunction(new Function(name));
+}
+
+void CodeGenerator::structPrototype(string name)
+{
+    if (!currentModule()->getStruct(name))
+        currentModule()->addStruct(new Struct(name));
+}
+
+Function* CodeGenerator::externalFunction(string name, Type* returnt, vector<Variable*> args)
+{
+    if (auto f = currentModule()->getFunction(name))
+        return f;
+    auto f = new Function(name, returnt);
+    f->formalParams = std::move(args);
+    currentModule()->addExternal(f);
+    return f;
 }
 
 Function* CodeGenerator::createFunction(string name, c::ast::Type* returnt)
@@ -17,10 +45,9 @@ Function* CodeGenerator::createFunction(string name, c::ast::Type* returnt)
     auto f = currentModule()->getFunction(name);
     if (!f) {
         f = new Function(name, returnt);
-        currentModule()->functions.push_back(f);
+        currentModule()->addFunction(f);
     }
     f->returnType = returnt;
-    setInsertPoint(f->block);
     return f;
 }
 
@@ -29,81 +56,147 @@ Struct* CodeGenerator::createStruct(string name, vector<Variable*> fields)
     auto tstruct = currentModule()->getStruct(name);
     if (!tstruct) {
         tstruct = new Struct(name, fields);
-        currentModule()->structs.push_back(tstruct);
+        currentModule()->addStruct(tstruct);
     } else
         tstruct->fields = fields;
     return tstruct;
 }
 
-Assigment* CodeGenerator::createAssignment(Variable* v, Expression* expr, bool decl)
+Assigment* Builder::createAssignment(Variable* v, Expression* expr, bool decl)
 {
     auto assig = new Assigment(v, expr, decl);
     blocks.top()->insert(assig);
     return assig;
 }
 
-VariableDeclaration* CodeGenerator::createDeclaration(Variable* v)
+VariableDeclaration* Builder::createDeclaration(Variable* v)
 {
     auto vd = new VariableDeclaration(v);
     blocks.top()->insert(vd);
     return vd;
 }
 
-Return* CodeGenerator::createReturn(Expression* expr)
+Return* Builder::createReturn(Expression* expr)
 {
     auto r = new Return(expr);
     blocks.top()->insert(r);
     return r;
 }
 
-FunctionCall* CodeGenerator::createFunctionCall(Function* func, vector<Expression*> args)
+FunctionCall* Builder::createFunctionCall(Function* func, vector<Expression*> args)
 {
     FunctionCall* fcall = new FunctionCall(func, args);
     blocks.top()->insert(fcall);
     return fcall;
 }
 
-FunctionCall* CodeGenerator::createFunctionCall(string name, vector<Expression*> args)
+///a file only changes when its content does, so make rebuilds just what was really regenerated
+static void replaceIfChanged(const string& generated, const string& path)
 {
-    return createFunctionCall(currentModule()->getFunction(name), args);
+    std::ifstream a(generated, std::ios::binary), b(path, std::ios::binary);
+    std::istreambuf_iterator<char> end;
+    bool same = b && std::equal(std::istreambuf_iterator<char>(a), end, std::istreambuf_iterator<char>(b), end);
+    a.close();
+    b.close();
+    if (same)
+        std::remove(generated.c_str());
+    else
+        std::rename(generated.c_str(), path.c_str());
 }
 
 void CodeGenerator::writeModule(Module* mod)
 {
-    std::cout << "writing to " << mod->name << ".c\n";
-    std::ofstream os(mod->name + ".c");
-
-    std::cout << "#include<stdlib.h>" << std::endl;
-    os << "#include<stdlib.h>" << std::endl;
-
-    std::cout << "#include<string.h>" << std::endl;
-    os << "#include<string.h>" << std::endl;
+    writeHeader(mod);
+    writeSource(mod);
+}
 
-    for (auto& e : mod->structs) {
-        std::cout << e->getDefinition();
-        os << e->getDefinition();
+void CodeGenerator::writeHeader(Module* mod)
+{
+    string path = mod->name + ".h";
+    if (echo)
+        std::cout << "writing to " << path << "\n";
+    {
+        std::ofstream os(path + ".tmp");
+        Writer out(os, echo ? &std::cout : nullptr);
+
+        string guard = "KVANTUM_" + mod->name + "_H";
+        std::transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
+        out << "#ifndef " << guard << '\n';
+        out << "#define " << guard << '\n';
+        for (auto& e : mod->imports)
+            out << "#include \"" << e << ".h\"\n";
+
+        for (auto& e : mod->structs)
+            e->writeDefinition(out);
+        for (auto& e : mod->exports) {
+            e->writePrototype(out);
+            out << '\n';
+        }
+        out << "#endif\n";
     }
+    replaceIfChanged(path + ".tmp", path);
+}
 
-    for (auto& e : mod->functions) {
-        std::cout << e->getPrototype() << std::endl;
-        os << e->getPrototype() << std::endl;
+void CodeGenerator::writeSource(Module* mod)
+{
+    string path = mod->name + ".c";
+    if (echo)
+        std::cout << "writing to " << path << "\n";
+    {
+        std::ofstream os(path + ".tmp");
+        Writer out(os, echo ? &std::cout : nullptr);
+
+        out << "#include<stdlib.h>\n";
+        out << "#include<string.h>\n";
+        out << "#include \"" << mod->name << ".h\"\n";
+
+        for (auto& e : mod->functions) {
+            e->writePrototype(out);
+            out << '\n';
+        }
+        out << '\n';
+        for (auto& e : mod->functions) {
+            e->writeDefinition(out);
+            out << '\n';
+        }
     }
-    std::cout << std::endl;
-    os << std::endl;
-    for (auto& e : mod->functions) {
-        std::cout << e->getDefiniton() << std::endl;
-        os << e->getDefiniton() << std::endl;
+    replaceIfChanged(path + ".tmp", path);
+}
+
+void CodeGenerator::writeUnity(Module* mod)
+{
+    string path = mod->name + ".c";
+    if (echo)
+        std::cout << "writing to " << path << "\n";
+    {
+        std::ofstream os(path + ".tmp");
+        Writer out(os, echo ? &std::cout : nullptr);
+
+        out << "#include<stdlib.h>\n";
+        out << "#include<string.h>\n";
+        for (auto& e : mod->structs)
+            e->writeDefinition(out);
+
+        for (auto& e : mod->functions) {
+            e->writePrototype(out);
+            out << '\n';
+        }
+        out << '\n';
+        for (auto& e : mod->functions) {
+            e->writeDefinition(out);
+            out << '\n';
+        }
     }
-    os.close();
+    replaceIfChanged(path + ".tmp", path);
 }
 
 void CodeGenerator::initStl()
 {
     Module* stl = new Module("stl");
-    stl->functions.push_back(new Function("printf"));
-    stl->functions.push_back(new Function("scanf"));
-    stl->functions.push_back(new Function("malloc"));
-    stl->functions.push_back(new Function("memcpy"));
+    stl->addFunction(new Function("printf"));
+    stl->addFunction(new Function("scanf"));
+    stl->addFunction(new Function("malloc"));
+    stl->addFunction(new Function("memcpy"));
     modules.push_back(stl);
 }
 } // namespace c::codegen
@@ -115,14 +208,15 @@ int main(void)
     c::codegen::CodeGenerator gen;
     gen.setModule("main");
     gen.functionPrototype("add");
-    gen.createFunction("main", Type::getInt8());
-    gen.createAssignment(new c::ast::Variable("asd", Type::getInt32()),
-                         new c::ast::Literal("10", Type::getInt32()),
-                         true);
-    gen.createFunctionCall("add");
-
-    gen.createFunction("add", Type::getInt8());
-    gen.createDeclaration(new c::ast::Variable("asd", Type::getFloat()));
+    c::codegen::Builder builder;
+    builder.setInsertPoint(gen.createFunction("main", Type::getInt8())->block);
+    builder.createAssignment(new c::ast::Variable("asd", Type::getInt32()),
+                             new c::ast::Literal("10", Type::getInt32()),
+                             true);
+    builder.createFunctionCall(gen.getFunction("add"), {});
+
+    builder.setInsertPoint(gen.createFunction("add", Type::getInt8())->block);
+    builder.createDeclaration(new c::ast::Variable("asd", Type::getFloat()));
     gen.writeGenerated();
 }
 
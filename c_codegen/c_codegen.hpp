@@ -5,6 +5,7 @@
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <unordered_map>
 
 using namespace c::ast;
 using std::stack;
@@ -15,11 +16,11 @@ namespace c::codegen
    {
       Module(string n) : name(n){}
 
-      Function* getFunction(string name)
+      Function* getFunction(const string& name)
       {
-         auto f = std::find_if(functions.begin(),functions.end(),[&name](Function* f){ return f->name == name; });
-         if(f < functions.end())
-            return *f;
+         auto f = functionIndex.find(name);
+         if(f != functionIndex.end())
+            return f->second;
          for(auto &e : dependecies){
             auto func = e->getFunction(name);
             if(func)
@@ -28,11 +29,11 @@ namespace c::codegen
          return nullptr;
       }
 
-      Struct* getStruct(string name)
+      Struct* getStruct(const string& name)
       {
-         auto f = std::find_if(structs.begin(),structs.end(),[&name](Struct* f){ return f->name == name; });
-         if(f < structs.end())
-            return *f;
+         auto f = structIndex.find(name);
+         if(f != structIndex.end())
+            return f->second;
          for(auto &e : dependecies){
             auto strct = e->getStruct(name);
             if(strct)
@@ -46,48 +47,98 @@ namespace c::codegen
          dependecies.push_back(m);
       }
 
+      ///the tables are only added to through these, so the indices stay complete
+      void addFunction(Function* f)
+      {
+         functions.push_back(f);
+         functionIndex.emplace(f->name,f);
+      }
+
+      void addExternal(Function* f)
+      {
+         externals.push_back(f);
+         functionIndex.emplace(f->name,f);
+      }
+
+      void addStruct(Struct* s)
+      {
+         structs.push_back(s);
+         structIndex.emplace(s->name,s);
+      }
+
       string name;
       vector<Function*> functions;
+      ///functions defined in other modules, they are declared by the headers of the imports
+      vector<Function*> externals;
       vector<Struct*> structs;
       vector<Module*> dependecies;
+      ///modules whose header is included
+      vector<string> imports;
+      ///functions declared in the header of the module
+      vector<Function*> exports;
+
+   private:
+      ///functions and externals by name, lookups of every call site go through it
+      std::unordered_map<string,Function*> functionIndex;
+      std::unordered_map<string,Struct*> structIndex;
    };
 
-   class CodeGenerator
+   ///inserts statements into the innermost open block of one function, functions with their own builder can be built concurrently
+   class Builder
    {
    public:
-      CodeGenerator() { initStl(); }
-      void setModule(string name);
-      void setInsertPoint(Block* f){ pushBlock(f); }
-
+      void setInsertPoint(Block* b){ pushBlock(b); }
       void pushBlock(Block* b = nullptr){ blocks.push(b ? b : new Block()); }
       void popBlock(){ blocks.pop(); }
       Assigment* createAssignment(Variable* v,Expression* expr,bool decl = false);
-      Function* createFunction(string name,c::ast::Type* returnt);
-      Struct* createStruct(string name,vector<Variable*> fields);
       VariableDeclaration* createDeclaration(Variable* v);
       Return* createReturn(Expression* expr);
-
       FunctionCall* createFunctionCall(Function* func,vector<Expression*> args);
-      FunctionCall* createFunctionCall(string name,vector<Expression*> args);
+   private:
+      stack<Block*> blocks;
+   };
+
+   class CodeGenerator
+   {
+   public:
+      CodeGenerator() { initStl(); }
+      void setModule(string name);
+      ///generates every following module into the one module of the program
+      void setUnity(string program);
+
+      ///the function of the module with the name, its body is built by a Builder
+      Function* createFunction(string name,c::ast::Type* returnt);
+      Struct* createStruct(string name,vector<Variable*> fields);
       void functionPrototype(string name,c::ast::Type* returnt = c::ast::Type::getVoid(),vector<Variable*> args = {});
-      void structPrototype(string name) { currentModule()->structs.push_back(new Struct(name)); }
+      ///the declaration of a function of another module, in a unity build its definition
+      Function* externalFunction(string name,c::ast::Type* returnt,vector<Variable*> args);
+      void structPrototype(string name);
+      void importModule(string name) { currentModule()->imports.push_back(name); }
+      void exportFunction(string name) { currentModule()->exports.push_back(getFunction(name)); }
       void setDependencies(vector<string> depends){/*todo*/}
+      ///also writes the generated C to stdout
+      void setEcho(bool e){ echo = e; }
 
-      void writeGenerated(){ writeModule(currentModule()); } 
-      Function* getFunction(string name)
+      ///writes <module>.c and <module>.h or the single C file of a unity build, a file whose content did not change is not touched
+      void writeGenerated(){ unity ? writeUnity(currentModule()) : writeModule(currentModule()); }
+      Function* getFunction(const string& name)
       { 
          auto f = currentModule()->getFunction(name);
          if(!f)
             throw std::invalid_argument("no function named "+name);
          return f; 
       }
-      Struct* getStruct(string name) { return currentModule()->getStruct(name); }
+      Struct* getStruct(const string& name) { return currentModule()->getStruct(name); }
    private:
       void writeModule(Module* mod);
+      void writeHeader(Module* mod);
+      void writeSource(Module* mod);
+      void writeUnity(Module* mod);
       Module* currentModule(){ return modules[modules.size()-1]; }
       void initStl();
 
       vector<Module*> modules;
-      stack<Block*> blocks;
+      bool echo = false;
+      bool unity = false;
    };
 }
\ No newline at end of file
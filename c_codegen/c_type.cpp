@@ -1,5 +1,6 @@
 #include "c_codegen/c_type.hpp"
 #include "c_codegen/c_ast.hpp"
+#include <mutex>
 
 namespace c::ast
 {
@@ -13,8 +14,12 @@ namespace c::ast
    Type* Type::getFloat(){ return new Float(1); }
    Type* Type::getDouble(){ return new Float(2); }
    Type* Type::getPointer(Type* t){ return new Pointer(t); }
+   ///functions of a module are generated concurrently
+   static std::mutex structsMutex;
+
    Type* Type::getStruct(Struct* s)
    {
+	   std::lock_guard<std::mutex> lock(structsMutex);
 	   if(StructType::mappedStructs.count(s))
 		   return StructType::mappedStructs[s];
 	   auto st = new StructType(s);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string_view>
+
+namespace c::ast
+{
+   /*
+      sink the C ast writes itself to, text is collected in one large buffer
+      and handed to the stream, and the echo stream if there is one, only when the buffer is full
+   */
+   class Writer
+   {
+   public:
+      static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+      Writer(std::ostream& out,std::ostream* echo = nullptr) : out(out),echo(echo),buffer(new char[BUFFER_SIZE]){}
+      Writer(const Writer&) = delete;
+      ~Writer(){ flush(); }
+
+      Writer& operator<<(std::string_view s)
+      {
+         if(s.size() > BUFFER_SIZE - used){
+            flush();
+            ///too large to be buffered at all
+            if(s.size() > BUFFER_SIZE){
+               put(s.data(),s.size());
+               return *this;
+            }
+         }
+         std::memcpy(buffer.get() + used,s.data(),s.size());
+         used += s.size();
+         return *this;
+      }
+
+      Writer& operator<<(char c)
+      {
+         if(used == BUFFER_SIZE)
+            flush();
+         buffer[used++] = c;
+         return *this;
+      }
+
+      void flush()
+      {
+         put(buffer.get(),used);
+         used = 0;
+      }
+
+   private:
+      void put(const char* data,size_t n)
+      {
+         out.write(data,n);
+         if(echo)
+            echo->write(data,n);
+      }
+
+      std::ostream& out;
+      std::ostream* echo;
+      std::unique_ptr<char[]> buffer;
+      size_t used = 0;
+   };
+}
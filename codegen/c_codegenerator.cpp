@@ -20,25 +20,60 @@ namespace kvantum::codegen
 
     void C_Generator::generateFunction(FunctionNode* func)
     {
-        std::cout << "generatring code for " << func->getName() << std::endl;
-        auto f = generator.createFunction(func->getID(), getCType(func->getReturnType()));
+        C_FunctionGenerator(*this).generate(func, createFunction(func));
+    }
+
+    c::ast::Function* C_Generator::createFunction(FunctionNode* func)
+    {
+        Diagnostics::log("generating code for " + func->getName());
+        auto f = generator.createFunction(cNameOf(func), getCType(func->getReturnType()));
         for (auto &e: func->formalParams) {
             f->formalParams.push_back(new c::ast::Variable(e->id, getCType(e->getType())));
         }
+        ///private functions are not in the header, they stay in their translation unit
+        if (func != entry) {
+            bool visible = !unity && func->hasTrait(FunctionNode::PUBLIC);
+            if (func->hasTrait(FunctionNode::EXPRESSION) && !visible)
+                f->linkage = c::ast::Function::STATIC_INLINE;
+            else if (!func->hasTrait(FunctionNode::PUBLIC))
+                f->linkage = c::ast::Function::STATIC;
+        }
+        cFunctions[func] = f;
+        return f;
+    }
+
+    string C_Generator::cNameOf(FunctionNode* func)
+    {
+        if (unity && func != entry && !func->hasTrait(FunctionNode::PUBLIC))
+            return moduleName + "_" + func->getID();
+        return func->getID();
+    }
+
+    c::ast::Function* C_Generator::functionOf(FunctionNode* func)
+    {
+        auto iter = cFunctions.find(func);
+        if (iter == cFunctions.end())
+            throw std::invalid_argument("no function generated for " + func->getName());
+        return iter->second;
+    }
+
+    void C_FunctionGenerator::generate(FunctionNode* func, c::ast::Function* f)
+    {
+        builder.setInsertPoint(f->block);
         for (auto &e: func->ast) {
             visit_statement(e);
         }
-        generator.popBlock();
+        builder.popBlock();
     }
 
     void C_Generator::prototypeFunction(FunctionNode* f)
     {
-        generator.functionPrototype(f->getID());
+        generator.functionPrototype(cNameOf(f));
     }
 
     void C_Generator::generateObject(ObjectType* t)
     {
-        std::cout << "generating code for " + t->getName() << std::endl;
+        Diagnostics::log("generating code for " + t->getName());
 
         generator.structPrototype(t->getTypeID());
         auto fields = t->getFields();
@@ -50,22 +85,60 @@ namespace kvantum::codegen
     void C_Generator::generate(Module* mod)
     {
         generator.setModule(mod->getName());
+        moduleName = mod->getName();
+        cFunctions.clear();
+        for (auto &e: mod->getDependencies())
+            generator.importModule(e);
+        for (auto &f: mod->getExternalFunctions()) {
+            vector<c::ast::Variable*> params;
+            for (auto &e: f->formalParams)
+                params.push_back(new c::ast::Variable(e->id, getCType(e->getType())));
+            cFunctions[f] = generator.externalFunction(f->getID(), getCType(f->getReturnType()), params);
+        }
         auto fns = mod->getFunctions();
         std::for_each(fns.begin(), fns.end(), [this](kvantum::FunctionNode* f) { this->prototypeFunction(f); });
+        for (auto &e: fns) {
+            if (e->hasTrait(FunctionNode::PUBLIC))
+                generator.exportFunction(e->getID());
+        }
 
         for (auto &e: mod->getObjectTypes())
             generateObject(e);
 
-        for (auto &e: mod->getFunctions())
-            generateFunction(e);
-    }
-
-    any C_Generator::visit(Literal* literal)
-    {
-        return (c::ast::Expression*) new c::ast::Literal(literal->value, getCType(literal->type));
+        ///the functions are created in declaration order and only their bodies are built concurrently
+        vector<c::ast::Function*> created;
+        for (auto &e: fns)
+            created.push_back(createFunction(e));
+        auto generateBatch = [&](size_t begin) {
+            size_t end = std::min(begin + BATCH_SIZE, fns.size());
+            for (size_t i = begin; i < end; i++)
+                C_FunctionGenerator(*this).generate(fns[i], created[i]);
+        };
+        if (fns.size() <= BATCH_SIZE) {
+            generateBatch(0);
+            return;
+        }
+        for (size_t begin = 0; begin < fns.size(); begin += BATCH_SIZE)
+            pool.submit([&generateBatch, begin] { generateBatch(begin); });
+        pool.wait();
+    }
+
+    any C_FunctionGenerator::visit(Literal* literal)
+    {
+        string value = literal->value;
+        ///folded numbers can be negative and the operands of a C operator are written without spaces
+        bool number = literal->type.isPrimitive() && (literal->type.asPrimitive().type == PrimitiveType::Integer
+                                                      || literal->type.asPrimitive().type == PrimitiveType::Float);
+        if (number && !value.empty() && value[0] == '-') {
+            ///the positive half of INT64_MIN does not fit into a long
+            if (value == std::to_string(INT64_MIN))
+                value = std::to_string(INT64_MIN + 1) + "-1";
+            value = "(" + value + ")";
+        }
+        return (c::ast::Expression*) new c::ast::Literal(value, owner.getCType(literal->type));
     }
 
-    any C_Generator::visit(BinaryOperation* bop)
+    any C_FunctionGenerator::visit(BinaryOperation* bop)
     {
         auto l = visitExpression(bop->lhs);
         auto r = visitExpression(bop->rhs);
@@ -73,9 +146,9 @@ namespace kvantum::codegen
         return (c::ast::Expression*) new c::ast::BinaryOperation(l, r, ops[bop->op]);
     }
 
-    any C_Generator::visit(Variable* var)
+    any C_FunctionGenerator::visit(Variable* var)
     {
-        c::ast::Expression* generated = new c::ast::Variable(var->id, getCType(var->getType()));
+        c::ast::Expression* generated = new c::ast::Variable(var->id, owner.getCType(var->getType()));
         if (var->isField()) {
             auto field = (c::ast::Variable*) generated;
             auto f = visitExpression(var->as<FieldAccess*>()->base);
@@ -84,84 +157,84 @@ namespace kvantum::codegen
         return generated;
     }
 
-    any C_Generator::visit(DynamicAllocation* alloc)
+    any C_FunctionGenerator::visit(DynamicAllocation* alloc)
     {
         auto getcoret = [this](Type &t) {
             if (t.isPrimitive())
-                return primitiveTypes[t.asPrimitive().type];
-            return c::ast::Type::getStruct(generator.getStruct(t.getName()));
+                return owner.primitiveTypes[t.asPrimitive().type];
+            return c::ast::Type::getStruct(owner.generator.getStruct(t.getName()));
         };
 
-        return (c::ast::Expression*) new c::ast::FunctionCall(generator.getFunction("malloc"), {visitExpression(alloc->getSizeExpr())});
+        return (c::ast::Expression*) new c::ast::FunctionCall(owner.generator.getFunction("malloc"), {visitExpression(alloc->getSizeExpr())});
     }
 
-    any C_Generator::visit(ArrayExpression* arr)
+    any C_FunctionGenerator::visit(ArrayExpression* arr)
     {
         return (c::ast::Expression*) new c::ast::ArrayExpression(apply(ITER_THROUGH(arr->initializer), std::function([this](Literal* e) {
             return (c::ast::Literal*) any_cast<c::ast::Expression*>(visit_expression(e));
         })));
     }
 
-    any C_Generator::visit(ArrayIndex* arr)
+    any C_FunctionGenerator::visit(ArrayIndex* arr)
     {
         auto arrExp = visitExpression(arr->baseArray);
         auto arrInd = visitExpression(arr->index);
         return (c::ast::Expression*) new c::ast::ArrayIndex(arrExp, static_cast<c::ast::Variable*>(arrInd));
     }
 
-    any C_Generator::visit(Cast* cast)
+    any C_FunctionGenerator::visit(Cast* cast)
     {
         return (c::ast::ArrayExpression*) nullptr;
     }
 
-    any C_Generator::visit(kvantum::TakeReference*)
+    any C_FunctionGenerator::visit(kvantum::TakeReference*)
     {
         return nullptr;
     }
 
-    void C_Generator::visit(Assigment* assig)
+    void C_FunctionGenerator::visit(Assigment* assig)
     {
         auto var = visitExpression(assig->variable);
         auto expr = visitExpression(assig->expr);
-        generator.createAssignment((c::ast::Variable*) var, expr, assig->isDeclaration());
+        builder.createAssignment((c::ast::Variable*) var, expr, assig->isDeclaration());
     }
 
-    void C_Generator::visit(If_Else* if_else)
+    void C_FunctionGenerator::visit(If_Else* if_else)
     {
 
     }
 
-    void C_Generator::visit(While* while_loop)
+    void C_FunctionGenerator::visit(While* while_loop)
     {
 
     }
 
-    void C_Generator::visit(For* for_loop) {}
+    void C_FunctionGenerator::visit(For* for_loop) {}
 
-    void C_Generator::visit(Return* ret)
+    void C_FunctionGenerator::visit(Return* ret)
     {
-        generator.createReturn(visitExpression(ret->expr));
+        builder.createReturn(visitExpression(ret->expr));
     }
 
-    any C_Generator::visit(FunctionCall* fcall)
+    any C_FunctionGenerator::visit(FunctionCall* fcall)
     {
         vector<c::ast::Expression*> args;
         for (auto &e: fcall->arguments) {
             args.push_back(visitExpression(e));
         }
         if (state == NodeState::isExpression)
-            return (c::ast::Expression*) new c::ast::FunctionCall(generator.getFunction(fcall->fnode->getID()), args);
+            return (c::ast::Expression*) new c::ast::FunctionCall(owner.functionOf(fcall->fnode), args);
         else
-            return generator.createFunctionCall(generator.getFunction(fcall->fnode->getID()), args);
+            return builder.createFunctionCall(owner.functionOf(fcall->fnode), args);
     }
 
-    void C_Generator::visit(StatementBlock* block)
+    void C_FunctionGenerator::visit(StatementBlock* block)
     {
-        generator.pushBlock();
+        builder.pushBlock();
         for (auto &e: block->block) {
             visit_statement(e);
         }
-        generator.popBlock();
+        builder.popBlock();
     }
 
     c::ast::Type* C_Generator::getCType(Type &t)
@@ -2,14 +2,34 @@
 #include "ast/ast.hpp"
 #include "ast/treevisitor.hpp"
 #include "common/module.hpp"
+#include "common/threadpool.hpp"
 #include "c_codegen/c_codegen.hpp"
 #include "codeexecutorinterface.hpp"
 
 namespace kvantum::codegen
 {
-class C_Generator : public TreeVisitor, public CodeExecutorInterface
+class C_Generator;
+
+///builds the body of one function, every function has its own so they can be generated concurrently
+class C_FunctionGenerator : public TreeVisitor
 {
     IMPLEMENTS_TREE_VISITOR
+public:
+    C_FunctionGenerator(C_Generator& owner) : owner(owner) {}
+    void generate(FunctionNode* func, c::ast::Function* f);
+
+private:
+    c::ast::Expression* visitExpression(Expression* e)
+    {
+        return any_cast<c::ast::Expression*>(TreeVisitor::visit_expression(e));
+    }
+
+    C_Generator& owner;
+    c::codegen::Builder builder;
+};
+
+class C_Generator : public CodeExecutorInterface
+{
 public:
     C_Generator();
     ~C_Generator();
@@ -19,16 +39,42 @@ public:
     void prototypeFunction(FunctionNode* f) override;
     void generateObject(ObjectType* t) override;
     void exec() override;
+    ///also writes the generated C to stdout
+    void setEcho(bool echo) { generator.setEcho(echo); }
+    ///main of the program, the only private function that stays external
+    void setEntry(FunctionNode* main) { entry = main; }
+    /*
+        generates the following modules into the single file of the program, => functions
+        become static inline so the C compiler can inline them anywhere
+    */
+    void setUnity(const string& program)
+    {
+        generator.setUnity(program);
+        unity = true;
+    }
 
 private:
+    friend class C_FunctionGenerator;
+    ///functions are generated in batches of this many on the pool
+    static constexpr size_t BATCH_SIZE = 64;
+
     c::ast::Type* getCType(Type& t);
-    c::ast::Expression* visitExpression(Expression* e)
-    {
-        return any_cast<c::ast::Expression*>(TreeVisitor::visit_expression(e));
-    }
+    ///the modules of a unity build share one file, so private functions carry the name of theirs
+    string cNameOf(FunctionNode* func);
+    ///the function of the module the body of func is built into
+    c::ast::Function* createFunction(FunctionNode* func);
+    ///the C function a call of func goes to, without building its mangled name
+    c::ast::Function* functionOf(FunctionNode* func);
 
     c::codegen::CodeGenerator generator;
     std::array<c::ast::Type*, PrimitiveType::Void + 1> primitiveTypes;
     std::map<string, Struct*> structs;
+    ///the functions and imports of the module being generated, filled before the bodies are built
+    std::unordered_map<FunctionNode*, c::ast::Function*> cFunctions;
+    ThreadPool pool;
+    FunctionNode* entry = nullptr;
+    bool unity = false;
+    ///the module being generated
+    string moduleName;
    };
 }
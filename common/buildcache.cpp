@@ -0,0 +1,131 @@
+#include "common/buildcache.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace kvantum {
+
+static constexpr const char *MANIFEST_VERSION = "kvcache 2";
+
+BuildCache::BuildCache(string directory)
+    : directory(std::move(directory))
+{}
+
+optional<CacheEntry> BuildCache::lookup(const string &moduleName) const
+{
+    std::ifstream is(manifestPath(moduleName));
+    if (is.fail())
+        return {};
+
+    string line;
+    if (!std::getline(is, line) || line != MANIFEST_VERSION)
+        return {};
+
+    CacheEntry entry;
+    bool hasSource = false, hasInterface = false;
+    while (std::getline(is, line)) {
+        std::istringstream fields(line);
+        string key;
+        fields >> key;
+        if (key == "source")
+            hasSource = static_cast<bool>(fields >> std::hex >> entry.sourceHash);
+        else if (key == "interface")
+            hasInterface = static_cast<bool>(fields >> std::hex >> entry.interfaceHash);
+        else if (key == "dep") {
+            pair<string, uint64_t> dep;
+            if (!(fields >> dep.first >> std::hex >> dep.second))
+                return {};
+            entry.dependencies.push_back(std::move(dep));
+        } else
+            return {};
+    }
+    if (!hasSource || !hasInterface)
+        return {};
+    return entry;
+}
+
+void BuildCache::store(const string &moduleName,
+                       const CacheEntry &entry,
+                       const vector<string> &generatedFiles,
+                       const optional<string> &interface)
+{
+    std::error_code err;
+    fs::create_directories(directory, err);
+    if (err) {
+        Diagnostics::warn("cannot create build cache " + directory + ": " + err.message());
+        return;
+    }
+    for (auto &file : generatedFiles) {
+        fs::copy_file(file, outputPath(file), fs::copy_options::overwrite_existing, err);
+        if (err) {
+            Diagnostics::warn("cannot cache " + file + ": " + err.message());
+            return;
+        }
+    }
+    ///an interface left from an older build must not be loaded with the new manifest
+    if (interface) {
+        std::ofstream os(interfacePath(moduleName), std::ios::binary | std::ios::trunc);
+        os.write(interface->data(), interface->size());
+        if (os.fail())
+            fs::remove(interfacePath(moduleName), err);
+    } else
+        fs::remove(interfacePath(moduleName), err);
+
+    ///the manifest is written last, so an interrupted store leaves no entry behind
+    std::ofstream os(manifestPath(moduleName));
+    os << MANIFEST_VERSION << "\n" << std::hex;
+    os << "source " << entry.sourceHash << "\n";
+    os << "interface " << entry.interfaceHash << "\n";
+    for (auto &dep : entry.dependencies)
+        os << "dep " << dep.first << " " << dep.second << "\n";
+}
+
+static bool sameContent(const string &a, const string &b)
+{
+    std::ifstream as(a, std::ios::binary), bs(b, std::ios::binary);
+    std::istreambuf_iterator<char> end;
+    return as && bs
+           && std::equal(std::istreambuf_iterator<char>(as), end, std::istreambuf_iterator<char>(bs), end);
+}
+
+bool BuildCache::restore(const vector<string> &generatedFiles) const
+{
+    for (auto &file : generatedFiles) {
+        ///an untouched file is not compiled again by make
+        if (sameContent(outputPath(file), file))
+            continue;
+        std::error_code err;
+        fs::copy_file(outputPath(file), file, fs::copy_options::overwrite_existing, err);
+        if (err)
+            return false;
+    }
+    return true;
+}
+
+bool BuildCache::hasOutput(const vector<string> &generatedFiles) const
+{
+    std::error_code err;
+    return std::all_of(generatedFiles.begin(), generatedFiles.end(), [&](const string &file) {
+        return fs::exists(outputPath(file), err);
+    });
+}
+
+string BuildCache::manifestPath(const string &moduleName) const
+{
+    return directory + "/" + moduleName + ".manifest";
+}
+
+string BuildCache::outputPath(const string &generatedFile) const
+{
+    return directory + "/" + fs::path(generatedFile).filename().string();
+}
+
+string BuildCache::interfacePath(const string &moduleName) const
+{
+    return directory + "/" + moduleName + ".kvi";
+}
+
+} // namespace kvantum
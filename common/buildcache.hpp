@@ -0,0 +1,72 @@
+#pragma once
+#include "util.hpp"
+#include <optional>
+#include <string_view>
+#include <utility>
+
+using std::optional;
+using std::pair;
+
+namespace kvantum {
+
+/*
+    64 bit FNV-1a hash, every added item is terminated so "ab","c" and "a","bc" differ
+*/
+class Hasher
+{
+public:
+    void add(std::string_view data)
+    {
+        for (unsigned char c : data)
+            mix(c);
+        mix(0xff);
+    }
+    uint64_t get() const { return hash; }
+
+private:
+    void mix(unsigned char c)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+
+    uint64_t hash = 14695981039346656037ull;
+};
+
+struct CacheEntry
+{
+    uint64_t sourceHash = 0;
+    uint64_t interfaceHash = 0;
+    ///imported modules with the interface hash they had when the module was built
+    vector<pair<string, uint64_t>> dependencies;
+};
+
+/*
+    on disk cache of built modules, every module has a manifest
+    and the C files generated from it under the cache directory
+*/
+class BuildCache
+{
+public:
+    explicit BuildCache(string directory = ".kvcache");
+
+    optional<CacheEntry> lookup(const string &moduleName) const;
+    /// records the entry and keeps a copy of the generated files and the serialized interface
+    void store(const string &moduleName,
+               const CacheEntry &entry,
+               const vector<string> &generatedFiles,
+               const optional<string> &interface);
+    /// copies the cached generated files back unless they are already identical, false if one is missing
+    bool restore(const vector<string> &generatedFiles) const;
+    bool hasOutput(const vector<string> &generatedFiles) const;
+    /// binary interface written next to the manifest, see ModuleInterface
+    string interfacePath(const string &moduleName) const;
+
+private:
+    string manifestPath(const string &moduleName) const;
+    string outputPath(const string &generatedFile) const;
+
+    string directory;
+};
+
+} // namespace kvantum
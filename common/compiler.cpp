@@ -1,13 +1,28 @@
 #include "common/compiler.hpp"
-#include "parser/parser.hpp"
+#include "common/moduleinterface.hpp"
+#include "lexer/sourcebuffer.hpp"
+#include "parser/moduleparser.hpp"
 #include "parser/typechecker.hpp"
 #include "codegen/c_codegenerator.hpp"
 #include "interpreter/interpreter.hpp"
+#include "interpreter/vm.hpp"
+#include "interpreter/profiler.hpp"
+#include "interpreter/constantfolder.hpp"
+#include "common/threadpool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <unordered_map>
 
-using kvantum::parser::Parser;
+using kvantum::parser::ModuleParser;
+using kvantum::lexer::SourceBuffer;
 using kvantum::parser::TypeChecker;
 using kvantum::codegen::C_Generator;
 using kvantum::interpreter::Interpreter;
+using kvantum::interpreter::VirtualMachine;
 
 namespace kvantum
 {
@@ -56,11 +71,256 @@ namespace kvantum
         }) < modules.end();
     }
 
+    void Compiler::checkModules()
+    {
+        std::unordered_map<string, size_t> moduleIndex;
+        for (size_t i = 0; i < modules.size(); i++)
+            moduleIndex.emplace(modules[i]->getName(), i);
+
+        ///a module is scheduled once every module it imports from is checked
+        vector<vector<size_t>> dependents(modules.size());
+        auto pending = std::make_unique<std::atomic<size_t>[]>(modules.size());
+        for (size_t i = 0; i < modules.size(); i++) {
+            pending[i] = 0;
+            for (auto &dep : modules[i]->getDependencies()) {
+                auto iter = moduleIndex.find(dep);
+                if (iter == moduleIndex.end() || iter->second == i)
+                    continue;
+                dependents[iter->second].push_back(i);
+                pending[i]++;
+            }
+        }
+
+        ///every module reports into its own DiagnosticContext, which the checker activates
+        ThreadPool pool;
+        std::function<void(size_t)> schedule = [&](size_t i) {
+            pool.submit([&, i] {
+                if (!modules[i]->isInterfaceOnly()) {
+                    TypeChecker tc;
+                    tc.checkModule(modules[i].get());
+                }
+                for (auto d : dependents[i]) {
+                    if (--pending[d] == 0)
+                        schedule(d);
+                }
+            });
+        };
+        ///the roots are collected first, the counters change as soon as the first module is checked
+        vector<size_t> roots;
+        for (size_t i = 0; i < modules.size(); i++) {
+            if (pending[i] == 0)
+                roots.push_back(i);
+        }
+        for (auto i : roots)
+            schedule(i);
+        pool.wait();
+    }
+
+    bool Compiler::hasError()
+    {
+        return DiagnosticContext::current().hasError()
+               || std::any_of(ITER_THROUGH(modules), [](unique_ptr<Module> &m) {
+                      return m->getDiagnostics().hasError();
+                  });
+    }
+
+    void Compiler::reportErrors()
+    {
+        ///modules are reported in the order they were added, independently of scheduling
+        DiagnosticContext::current().print();
+        for (auto &m : modules)
+            m->getDiagnostics().print();
+    }
+
     void Compiler::addModule(unique_ptr<Module> mod)
     {
         modules.push_back(std::move(mod));
-        kvantum::Diagnostics::setWorkingModule(modules[modules.size() - 1]->getName());
-        kvantum::Diagnostics::setLineIndex(0);
+    }
+
+    Module* Compiler::requireModule(const string& name, const string& fileName)
+    {
+        if (hasModule(name))
+            return getModule(name);
+        ///a module is only added once its parsed, so an import of a module still being loaded is a cycle
+        if (loading.count(name)) {
+            panic("cyclic import of module " + name);
+            return nullptr;
+        }
+        loading.insert(name);
+        Module* mod = loadModule(name, fileName);
+        loading.erase(name);
+        return mod;
+    }
+
+    Module* Compiler::loadModule(const string& name, const string& fileName)
+    {
+        ///a module which is not rebuilt only has to provide its interface to the importer
+        if (!planModule(name, fileName) && loadInterfaces) {
+            auto mod = ModuleInterface::load(name, fileName, cache.interfacePath(name));
+            ///an interface that does not load as what was saved would make every importer stale
+            if (mod && mod->getInterfaceHash() != units.at(name).cached->interfaceHash) {
+                Diagnostics::warn("interface of " + name + " does not match its hash");
+                mod.reset();
+            }
+            if (mod) {
+                Diagnostics::log("loaded interface of " + name);
+                addModule(std::move(mod));
+                return modules.back().get();
+            }
+        }
+        Diagnostics::log("parsing " + fileName);
+        ModuleParser parser(fileName);
+        addModule(parser.parse());
+        return modules.back().get();
+    }
+
+    bool Compiler::planModule(const string& name, const string& fileName)
+    {
+        auto iter = units.find(name);
+        if (iter != units.end())
+            return iter->second.stale;
+
+        BuildUnit& unit = units[name];
+        unit.fileName = fileName;
+        auto source = SourceBuffer::open(fileName);
+        if (source) {
+            Hasher h;
+            h.add(source->getText());
+            unit.sourceHash = h.get();
+        }
+        unit.cached = cache.lookup(name);
+        unit.sourceChanged = !source || !unit.cached || unit.cached->sourceHash != unit.sourceHash
+                             || !cache.hasOutput(outputsOf(name));
+        unit.stale = unit.sourceChanged;
+        ///the imports of a changed module are only known once its parsed
+        if (!unit.sourceChanged) {
+            for (auto& dep : unit.cached->dependencies) {
+                string depFile = Module::directoryOf(fileName) + dep.first + ".kv";
+                ///a stale import may keep its interface, that is decided after its rebuilt
+                if (planModule(dep.first, depFile) || units[dep.first].cached->interfaceHash != dep.second)
+                    unit.stale = true;
+            }
+        }
+        buildOrder.push_back(name);
+        return unit.stale;
+    }
+
+    uint64_t Compiler::currentInterfaceHash(const string& name)
+    {
+        if (hasModule(name))
+            return getModule(name)->getInterfaceHash();
+        auto& unit = units.at(name);
+        return unit.cached ? unit.cached->interfaceHash : 0;
+    }
+
+    void Compiler::emitModule(const string& name, codegen::C_Generator& generator)
+    {
+        auto& unit = units.at(name);
+        auto outputs = outputsOf(name);
+        if (!hasModule(name) || getModule(name)->isInterfaceOnly()) {
+            ///not stale, nothing was parsed
+            if (!cache.restore(outputs))
+                Diagnostics::warn("cached output of " + name + " is missing");
+            return;
+        }
+
+        Module* mod = getModule(name);
+        CacheEntry entry;
+        entry.sourceHash = unit.sourceHash;
+        entry.interfaceHash = mod->getInterfaceHash();
+        for (auto& dep : mod->getDependencies())
+            entry.dependencies.emplace_back(dep, currentInterfaceHash(dep));
+
+        ///parsed only because an importer needed it, or rebuilt with unchanged imports
+        if (!unit.sourceChanged && unit.cached->dependencies == entry.dependencies
+            && cache.restore(outputs)) {
+            Diagnostics::log(name + " is up to date");
+            return;
+        }
+
+        generator.generate(mod);
+        generator.exec();
+        cache.store(name, entry, outputs, ModuleInterface::serialize(*mod));
+    }
+
+    vector<string> Compiler::outputsOf(const string& name)
+    {
+        return {name + ".c", name + ".h"};
+    }
+
+    vector<string> Compiler::importsOf(const string& name)
+    {
+        if (hasModule(name) && !getModule(name)->isInterfaceOnly())
+            return getModule(name)->getDependencies();
+        vector<string> imports;
+        auto& unit = units.at(name);
+        if (unit.cached) {
+            for (auto& dep : unit.cached->dependencies)
+                imports.push_back(dep.first);
+        }
+        return imports;
+    }
+
+    void Compiler::writeMakefile(const string& program)
+    {
+        ///planning visits the modules in a different order when some are cached
+        vector<string> names = buildOrder;
+        std::sort(ITER_THROUGH(names));
+
+        std::ostringstream out;
+        out << "# generated by Kvantum-Transpiler, run with make -j to compile the modules in parallel\n";
+        out << "CFLAGS ?= -O2\n";
+        if (unity) {
+            out << "\n" << program << ": " << program << ".c\n\t$(CC) $(CFLAGS) $(LDFLAGS) -o $@ " << program
+                << ".c\n";
+            out << "\nclean:\n\trm -f " << program << "\n\n.PHONY: clean\n";
+        } else {
+            out << "OBJECTS =";
+            for (auto& name : names)
+                out << " " << name << ".o";
+            out << "\n\n" << program << ": $(OBJECTS)\n\t$(CC) $(LDFLAGS) -o $@ $(OBJECTS)\n\n";
+
+            for (auto& name : names) {
+                out << name << ".o: " << name << ".c";
+                ///headers include the headers of their imports
+                std::set<string> visited = {name};
+                vector<string> pending = {name};
+                while (!pending.empty()) {
+                    string next = pending.back();
+                    pending.pop_back();
+                    out << " " << next << ".h";
+                    for (auto& dep : importsOf(next)) {
+                        if (visited.insert(dep).second)
+                            pending.push_back(dep);
+                    }
+                }
+                out << "\n\t$(CC) $(CFLAGS) -c -o $@ " << name << ".c\n";
+            }
+            out << "\nclean:\n\trm -f " << program << " $(OBJECTS)\n\n.PHONY: clean\n";
+        }
+
+        ///left untouched when nothing changed, like the generated C
+        std::ifstream current("Makefile", std::ios::binary);
+        std::ostringstream previous;
+        previous << current.rdbuf();
+        if (current && previous.str() == out.str())
+            return;
+        std::ofstream("Makefile", std::ios::binary) << out.str();
+    }
+
+    vector<string> Compiler::dependencyOrder(const string& name)
+    {
+        vector<string> order;
+        std::set<string> visited;
+        std::function<void(const string&)> visit = [&](const string& mod) {
+            if (!visited.insert(mod).second)
+                return;
+            for (auto& dep : importsOf(mod))
+                visit(dep);
+            order.push_back(mod);
+        };
+        visit(name);
+        return order;
     }
 
     void Compiler::compile(const string& filename)
@@ -71,88 +331,123 @@ namespace kvantum
         }
 
         Diagnostics::setVerbosity(Diagnostics::Verbosity::ERROR);
-        deque<string> incl;
-        incl.push_back(filename);
-        Parser parser(incl, this);
-        parser.Parse();
-        if (kvantum::Diagnostics::hasError()) {
-            kvantum::Diagnostics::fail();
-            exit(1);
+        ///only stale modules are parsed, they parse the modules they import on demand
+        planModule(Module::nameOf(filename), filename);
+        ///a unity build generates every module, so none can be loaded from its interface
+        if (unity)
+            loadInterfaces = false;
+        auto planned = buildOrder;
+        for (auto& name : planned) {
+            if (unity || units.at(name).stale)
+                requireModule(name, units.at(name).fileName);
         }
+        exitOnError();
 
         Diagnostics::log("code parsed");
-        TypeChecker tc;
-        for (int i = 0; i < modules.size(); i++) {
-            kvantum::Diagnostics::setWorkingModule(modules[i]->getName());
-            kvantum::Diagnostics::setLineIndex(0);
-            tc.checkModule(modules[i].get());
-        }
-        if (kvantum::Diagnostics::hasError()) {
-            kvantum::Diagnostics::fail();
-            exit(1);
-        }
+        checkModules();
+        exitOnError();
 
         Diagnostics::log("analysis success");
-        auto *ce = new kvantum::codegen::C_Generator();
-        for (int i = 0; i < modules.size(); i++) {
-            ce->generate(modules[i].get());
+        ///calls of => functions on constants are evaluated once here instead of in the generated code
+        interpreter::ConstantFolder folder;
+        for (auto& name : buildOrder) {
+            if (hasModule(name) && !getModule(name)->isInterfaceOnly())
+                folder.fold(getModule(name));
         }
-        ce->exec();
-        delete ce;
-        //std::cout << "code generated" << std::endl;
-        //system((string("gcc ")+modules[1]->getName() + ".c -o "+ modules[1]->getName()).c_str());
-    }
+        exitOnError();
 
-    void kvantum::Diagnostics::warn(string msg)
-    {
-        if (verbosity >= Verbosity::WARNING)
-            errors[workModule].emplace(msg, workModule, lineIndex);
+        C_Generator generator;
+        generator.setEcho(printGenerated);
+        string program = Module::nameOf(filename);
+        ///an up to date program is not loaded, there is nothing of it to generate
+        if (hasModule(program))
+            generator.setEntry(getModule(program)->getMainFunction());
+        if (unity) {
+            generator.setUnity(program);
+            for (auto& name : dependencyOrder(program))
+                generator.generate(getModule(name));
+            generator.exec();
+        } else {
+            for (auto& name : buildOrder)
+                emitModule(name, generator);
+        }
+        writeMakefile(program);
+
+        if (runMake) {
+            string command = "make -j" + std::to_string(ThreadPool::defaultThreadCount());
+            Diagnostics::log(command);
+            if (std::system(command.c_str()) != 0)
+                exit(1);
+        }
     }
 
-    void kvantum::Diagnostics::error(string msg)
+    int Compiler::run(const string& filename, bool treeWalk, interpreter::Profiler* profiler)
     {
-        if (verbosity == Verbosity::ABORT)
-            throw std::invalid_argument(msg + " -> at " + workModule + ":" + std::to_string(lineIndex));
-        if (verbosity >= Verbosity::ERROR)
-            errors[workModule].emplace(msg, workModule, lineIndex);
+        if (!fileExists(filename)) {
+            std::cerr << "Cannot find " << filename << std::endl;
+            return 1;
+        }
+
+        Diagnostics::setVerbosity(Diagnostics::Verbosity::ERROR);
+        loadInterfaces = false;
+        Module* mod = requireModule(Module::nameOf(filename), filename);
+        exitOnError();
+        checkModules();
+        exitOnError();
+
+        interpreter::Value result;
+        if (treeWalk) {
+            Interpreter interpreter;
+            if (profiler) {
+                for (auto& m : modules)
+                    profiler->addModule(m.get());
+            }
+            interpreter.setProfiler(profiler);
+            interpreter.generate(mod);
+            try {
+                interpreter.exec();
+            } catch (interpreter::RuntimeError& e) {
+                std::cerr << "runtime error: " << e.what() << std::endl;
+                return 1;
+            }
+            result = interpreter.getResult();
+        } else {
+            VirtualMachine vm;
+            {
+                DiagnosticContext::Activation diagnostics(mod->getDiagnostics());
+                vm.generate(mod);
+            }
+            exitOnError();
+            try {
+                vm.exec();
+            } catch (interpreter::RuntimeError& e) {
+                std::cerr << "runtime error: " << e.what() << std::endl;
+                return 1;
+            }
+            result = vm.getResult();
+        }
+        return result.isInt() ? result.asInt() : 0;
     }
 
-    void kvantum::Diagnostics::log(string msg)
+    int Compiler::profile(const string& filename)
     {
-        if (verbosity >= Verbosity::LOG)
-            std::cout << msg << std::endl;
+        interpreter::Profiler profiler;
+        int code = run(filename, true, &profiler);
+        profiler.writeReport(std::cerr);
+        string collapsed = Module::nameOf(filename) + ".collapsed";
+        std::ofstream out(collapsed);
+        profiler.writeCollapsed(out);
+        std::cerr << "call stacks written to " << collapsed << std::endl;
+        return code;
     }
 
-    void kvantum::Diagnostics::fail()
+    void Compiler::exitOnError()
     {
-        for (auto &e: errors) {
-            std::ifstream is;
-            is.open(e.first);
-            string s = "";
-            unsigned int lineIdx = 0;
-            while (!e.second.empty()) {
-                ///if already stepped over the line reset the file
-                if (lineIdx > e.second.front().lineIndex) {
-                    lineIdx = 0;
-                    is.seekg(0, std::ios::beg);
-                }
-
-                ///step until the specified lineidx
-                while (lineIdx != e.second.front().lineIndex) {
-                    std::getline(is, s);
-                    lineIdx++;
-                }
-                std::cout << e.second.front().message + " at line " + std::to_string(e.second.front().lineIndex) + " file: " + e.first << "\n";
-                std::cout << s << "\n\n";
-                e.second.pop();
-            }
-            is.close();
+        if (hasError()) {
+            reportErrors();
+            exit(1);
         }
     }
 
     Compiler Compiler::instance = {};
-    map<string, queue<Error>> kvantum::Diagnostics::errors = {};
-    unsigned int kvantum::Diagnostics::lineIndex = 0;
-    string kvantum::Diagnostics::workModule = "";
-    Diagnostics::Verbosity Diagnostics::verbosity = Diagnostics::Verbosity::WARNING;
 }
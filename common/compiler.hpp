@@ -1,13 +1,33 @@
 #pragma once
 #include "ast/ast.hpp"
+#include "buildcache.hpp"
 #include "module.hpp"
+#include <map>
+#include <set>
 
 namespace kvantum
 {
+    namespace codegen {
+    class C_Generator;
+    }
+    namespace interpreter {
+    class Profiler;
+    }
+
 	class Compiler
 	{
 	public:
 		void compile(const string& file);
+		///interprets the main function of the file on the bytecode vm or the tree walker, returns the exit code
+		int run(const string& file, bool treeWalk = false, interpreter::Profiler* profiler = nullptr);
+		///runs on the tree walker, reports the hot functions and lines on stderr and writes <module>.collapsed
+		int profile(const string& file);
+		///echoes the generated C to stdout while its written
+		void setPrintGenerated(bool print) { printGenerated = print; }
+		///runs the generated Makefile on every core once the C files are written
+		void setRunMake(bool run) { runMake = run; }
+		///generates every module into one <file>.c so the C compiler optimizes across modules
+		void setUnity(bool u) { unity = u; }
 		vector<FunctionNode*> getFunctionGroup(string modname,string funcname);
 		ObjectType& getObject(string modname, string objname);
 
@@ -17,10 +37,59 @@ namespace kvantum
 		Module* getModule(string name);
 		bool hasModule(string name);
 		void addModule(unique_ptr<Module> mod);
+		///loads the module unless its already loaded, from its cached interface if its not stale,
+		///nullptr if the module imports itself through the modules being loaded
+		Module* requireModule(const string& name, const string& fileName);
+
+		bool hasError();
+		///prints the errors of every module in module order
+		void reportErrors();
 	private:
         Compiler();
+        ///type checks the modules in parallel, following the import order
+        void checkModules();
+        void exitOnError();
+
+        /*
+            build state of a module reachable from the compiled file,
+            a module is stale if it has to be parsed again because its source
+            or the interface of a module it imports changed since it was cached
+        */
+        struct BuildUnit
+        {
+            string fileName;
+            uint64_t sourceHash = 0;
+            optional<CacheEntry> cached;
+            bool sourceChanged = true;
+            bool stale = true;
+        };
+        Module* loadModule(const string& name, const string& fileName);
+        ///decides from the cache manifests if the module is stale, returns staleness
+        bool planModule(const string& name, const string& fileName);
+        uint64_t currentInterfaceHash(const string& name);
+        ///generates the C file of the module or restores it from the cache if nothing changed
+        void emitModule(const string& name, codegen::C_Generator& generator);
+        ///the files generated from a module, <module>.c and <module>.h
+        static vector<string> outputsOf(const string& name);
+        ///modules imported by the module, from its manifest if it was not parsed
+        vector<string> importsOf(const string& name);
+        ///links every module into the program, an object depends on the headers it includes transitively
+        void writeMakefile(const string& program);
+        ///the module and everything it imports, every module after its imports
+        vector<string> dependencyOrder(const string& name);
 
         vector<unique_ptr<Module>> modules;
+        BuildCache cache;
+        std::map<string, BuildUnit> units;
+        ///modules whose parsing or interface loading has started but not finished
+        std::set<string> loading;
+        ///modules in the order they were planned
+        vector<string> buildOrder;
+        ///the interpreter needs function bodies, which cached interfaces do not have
+        bool loadInterfaces = true;
+        bool printGenerated = false;
+        bool runMake = false;
+        bool unity = false;
 
     public:
         static Compiler& Instance() { return instance; }
@@ -0,0 +1,64 @@
+#include "common/diagnostics.hpp"
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+namespace kvantum {
+
+void DiagnosticContext::warn(string msg)
+{
+    if (Diagnostics::getVerbosity() >= Diagnostics::WARNING)
+        errors.emplace_back(std::move(msg), moduleName, lineIndex);
+}
+
+void DiagnosticContext::error(string msg)
+{
+    if (Diagnostics::getVerbosity() == Diagnostics::ABORT)
+        throw std::invalid_argument(msg + " -> at " + moduleName + ":" + std::to_string(lineIndex));
+    if (Diagnostics::getVerbosity() >= Diagnostics::ERROR)
+        errors.emplace_back(std::move(msg), moduleName, lineIndex);
+}
+
+void DiagnosticContext::print() const
+{
+    std::ifstream is;
+    is.open(moduleName);
+    string s = "";
+    unsigned int lineIdx = 0;
+    for (auto &e : errors) {
+        ///if already stepped over the line reset the file
+        if (lineIdx > e.lineIndex) {
+            lineIdx = 0;
+            is.clear();
+            is.seekg(0, std::ios::beg);
+        }
+
+        ///step until the specified lineidx
+        while (lineIdx != e.lineIndex && std::getline(is, s))
+            lineIdx++;
+        std::cout << e.message + " at line " + std::to_string(e.lineIndex) + " file: " + moduleName
+                  << "\n";
+        std::cout << s << "\n\n";
+    }
+}
+
+DiagnosticContext &DiagnosticContext::current()
+{
+    static thread_local DiagnosticContext fallback;
+    return active ? *active : fallback;
+}
+
+void Diagnostics::log(string msg)
+{
+    static std::mutex logMutex;
+    if (verbosity >= Verbosity::LOG) {
+        std::lock_guard<std::mutex> lock(logMutex);
+        std::cout << msg << std::endl;
+    }
+}
+
+thread_local DiagnosticContext *DiagnosticContext::active = nullptr;
+Diagnostics::Verbosity Diagnostics::verbosity = Diagnostics::Verbosity::WARNING;
+
+} // namespace kvantum
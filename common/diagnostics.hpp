@@ -3,6 +3,7 @@
 #include <queue>
 #include <string>
 #include <utility>
+#include <vector>
 using std::map;
 using std::queue;
 using std::string;
@@ -22,26 +23,85 @@ struct Error
     unsigned int lineIndex;
 };
 
+/*
+    collects the diagnostics of one compilation unit
+    the unit activates its context on the thread working on it, so units can be
+    processed concurrently without sharing any diagnostic state
+*/
+class DiagnosticContext
+{
+public:
+    explicit DiagnosticContext(string moduleName = "")
+        : moduleName(std::move(moduleName))
+    {}
+    DiagnosticContext(const DiagnosticContext &) = delete;
+    DiagnosticContext &operator=(const DiagnosticContext &) = delete;
+
+    void warn(string msg);
+    void error(string msg);
+
+    /// line reported by warn and error, advanced by the lexer and the tree visitors
+    void setLineIndex(unsigned int lnIndex) { lineIndex = lnIndex; }
+    unsigned int getLineIndex() const { return lineIndex; }
+    const string &getModuleName() const { return moduleName; }
+    void setModuleName(string name) { moduleName = std::move(name); }
+
+    bool hasError() const { return !errors.empty(); }
+    /// prints every error with the source line it points at
+    void print() const;
+
+    /*
+        makes the context the target of Diagnostics on this thread until the activation goes out of scope
+    */
+    class Activation
+    {
+    public:
+        explicit Activation(DiagnosticContext &context)
+            : previous(active)
+        {
+            active = &context;
+        }
+        ~Activation() { active = previous; }
+
+    private:
+        DiagnosticContext *previous;
+    };
+
+    /// the context activated on this thread or the thread's own fallback context
+    static DiagnosticContext &current();
+
+private:
+    string moduleName;
+    unsigned int lineIndex = 0;
+    std::vector<Error> errors;
+
+    static thread_local DiagnosticContext *active;
+};
+
+/*
+    static facade over the current DiagnosticContext
+*/
 class Diagnostics
 {
 public:
     enum Verbosity { NONE, ERROR, WARNING, LOG, ABORT };
-    static void warn(string msg);
-    static void error(string msg);
+    static void warn(string msg) { DiagnosticContext::current().warn(std::move(msg)); }
+    static void error(string msg) { DiagnosticContext::current().error(std::move(msg)); }
     static void log(string msg);
     static void setVerbosity(Verbosity v) { verbosity = v; }
+    static Verbosity getVerbosity() { return verbosity; }
+    static bool isLogging() { return verbosity >= LOG; }
 
-    static void setWorkingModule(string modname) { workModule = std::move(modname); }
-    static void setLineIndex(unsigned int lnIndex) { lineIndex = lnIndex; }
+    static void setLineIndex(unsigned int lnIndex)
+    {
+        DiagnosticContext::current().setLineIndex(lnIndex);
+    }
+    static unsigned int getLineIndex() { return DiagnosticContext::current().getLineIndex(); }
 
-    static bool hasError() { return !errors.empty(); }
-    static void fail();
-    static unsigned int getLineIndex() { return lineIndex; }
+    static bool hasError() { return DiagnosticContext::current().hasError(); }
+    static void fail() { DiagnosticContext::current().print(); }
 
 private:
-    static map<string, queue<Error>> errors;
-    static unsigned int lineIndex;
-    static string workModule;
     static Verbosity verbosity;
 };
 
@@ -1,17 +1,20 @@
 #include "common/module.hpp"
+#include "common/buildcache.hpp"
 #include "common/compiler.hpp"
 #include <algorithm>
 
 namespace kvantum {
-Module::Module(const string &n)
-    : name(n)
+Module::Module(const string &n, const string &fileName)
+    : diagnostics(fileName.empty() ? n : fileName)
+    , name(n)
+    , fileName(fileName.empty() ? n : fileName)
 {
     for (auto t : PrimitiveType::getTypes()) {
         types.push_back(t);
     }
     types.push_back(&ObjectType::getObject());
-    externalFunctionIndex = 0;
-    externalTypeIndex = 0;
+    for (auto t : types)
+        typeIndex.emplace(t->getSymbol(), TypeEntry{t, false});
 }
 
 Module::~Module()
@@ -24,51 +27,67 @@ Module::~Module()
 
 void Module::addFunction(unique_ptr<FunctionNode> f)
 {
+    internalFunctionNames.insert(f->getSymbol());
+    indexFunction(f.get());
     functions.push_back(std::move(f));
 }
 
+bool Module::indexFunction(FunctionNode *f)
+{
+    auto &group = overloads[f->getSymbol()];
+    ///an imported type can bring in a function that was already imported by name
+    if (std::find(ITER_THROUGH(group), f) != group.end())
+        return false;
+    group.push_back(f);
+    signatures[f->getFunctionID().hash()].push_back(f);
+    return true;
+}
+
 bool Module::hasInternalFunction(string name)
 {
-    for (int i = externalFunctionIndex; i < functions.size(); i++) {
-        if (functions[i]->getName() == name)
-            return true;
-    }
-    return false;
+    return internalFunctionNames.count(SymbolTable::intern(name)) > 0;
 }
 
 bool Module::hasInternalType(string name)
 {
-    auto iter = findType(name);
-    return iter < types.end() && iter >= types.begin() + externalTypeIndex;
+    auto iter = typeIndex.find(SymbolTable::intern(name));
+    return iter != typeIndex.end() && !iter->second.external;
 }
 
 void Module::addExternalFunctionDependency(string moduleName, string funcname)
 {
+    addDependency(moduleName);
     auto funcs = Compiler::Instance().getFunctionGroup(moduleName, funcname);
     for (auto &func : funcs) {
         KVANTUM_VERIFY(func->hasTrait(FunctionNode::PUBLIC),
                        "cannot use function " + funcname + " because its private for module "
                            + getName());
-        else
-        {
-            functions.insert(functions.begin(), func);
-            externalFunctionIndex++;
+        else if (indexFunction(func)) {
+            externalFunctions.insert(func);
+            importedFunctions.push_back(func);
         }
     }
 }
 
 void Module::addExternalObjectDependency(string moduleName, string typen)
 {
-    types.insert(types.begin(), &Compiler::Instance().getObject(moduleName, typen));
-    externalTypeIndex++;
-    if ((*types.begin())->isObject()) {
-        for (auto &e : (*types.begin())->asObject().getMethods()) {
+    addDependency(moduleName);
+    Type &type = Compiler::Instance().getObject(moduleName, typen);
+    typeIndex[type.getSymbol()] = TypeEntry{&type, true};
+    if (type.isObject()) {
+        for (auto &e : type.asObject().getMethods()) {
             if (e.second->hasTrait(FunctionNode::PUBLIC))
                 addExternalFunctionDependency(moduleName, e.second->getName());
         }
     }
 }
 
+void Module::addDependency(const string &moduleName)
+{
+    if (std::find(ITER_THROUGH(dependencies), moduleName) == dependencies.end())
+        dependencies.push_back(moduleName);
+}
+
 ObjectType &Module::getObject(string name)
 {
     return (ObjectType &) getType(name);
@@ -76,42 +95,53 @@ ObjectType &Module::getObject(string name)
 
 Type &Module::getType(string name)
 {
-    return **findType(name);
+    return getType(SymbolTable::intern(name));
+}
+
+Type &Module::getType(SymbolID name)
+{
+    Type *type = findType(name);
+    if (!type)
+        throw std::invalid_argument("no type named " + SymbolTable::getName(name));
+    return *type;
 }
 
 FunctionNode *Module::getFunction(const FunctionNode::FunctionIdentifier id)
 {
-    return *findFunction(id);
+    return findFunction(id);
 }
 
 vector<FunctionNode *> Module::getFunctionGroup(string name)
 {
-    vector<FunctionNode *> funcs;
-    for (auto &e : functions) {
-        if (e->getName() == name)
-            funcs.push_back(e);
-    }
-    if (funcs.empty())
+    auto iter = overloads.find(SymbolTable::intern(name));
+    if (iter == overloads.end()) {
         panic("no function named " + name + " in module " + this->getName());
-    return funcs;
+        return {};
+    }
+    return iter->second;
 }
 
 bool Module::hasFunction(const FunctionNode::FunctionIdentifier id)
 {
-    return findFunction(id) != functions.end();
+    return findFunction(id) != nullptr;
 }
 
 bool Module::hasType(string name)
 {
-    return findType(name) < types.end();
+    return hasType(SymbolTable::intern(name));
+}
+
+bool Module::hasType(SymbolID name)
+{
+    return findType(name) != nullptr;
 }
 
 vector<FunctionNode *> Module::getFunctions()
 {
     std::vector<FunctionNode *> funcs;
-    std::for_each(functions.begin() + externalFunctionIndex,
-                  functions.end(),
-                  [&funcs](FunctionNode *f) { funcs.push_back(f); });
+    funcs.reserve(functions.size());
+    for (auto &f : functions)
+        funcs.push_back(f.get());
     return funcs;
 }
 
@@ -122,34 +152,98 @@ string Module::getName()
 
 FunctionNode *Module::getMainFunction()
 {
-    return functions[externalFunctionIndex];
+    ///methods can be defined before main, so it is looked up by name and the first function is the fallback
+    auto iter = overloads.find(SymbolTable::intern("main"));
+    if (iter != overloads.end() && !iter->second.empty())
+        return iter->second.front();
+    return functions.empty() ? nullptr : functions.front().get();
 }
 
 vector<ObjectType *> Module::getObjectTypes()
 {
-    return apply((vector<Type *>::iterator) types.begin() + PrimitiveType::Void + 1
-                     + externalTypeIndex,
+    ///skip the primitives and Object, they are not owned by the module
+    return apply((vector<Type *>::iterator) types.begin() + PrimitiveType::Void + 2,
                  types.end(),
                  std::function(
                      [](Type *t) -> ObjectType * { return dynamic_cast<ObjectType *>(t); }));
 }
 
-vector<FunctionNode *>::iterator Module::findFunction(const FunctionNode::FunctionIdentifier &e)
+FunctionNode *Module::findFunction(const FunctionNode::FunctionIdentifier &e)
+{
+    auto iter = signatures.find(e.hash());
+    if (iter != signatures.end()) {
+        ///candidates only share the hash, compare the full signature
+        for (auto f : iter->second) {
+            if (e == f->getFunctionID())
+                return f;
+        }
+    }
+    ///no exact match, take the first inherited overload which accepts derived objects for its parameters
+    auto group = overloads.find(e.symbol);
+    if (group == overloads.end())
+        return nullptr;
+    for (auto f : group->second) {
+        auto &params = f->formalParams;
+        if (params.size() != e.params.size() || !e.getBaseType().isAssignableTo(f->getParent()))
+            continue;
+        size_t i = 0;
+        while (i < params.size() && e.params[i]->isAssignableTo(params[i]->getType()))
+            i++;
+        if (i == params.size())
+            return f;
+    }
+    return nullptr;
+}
+
+Type *Module::findType(SymbolID name)
+{
+    auto iter = typeIndex.find(name);
+    return iter != typeIndex.end() ? iter->second.type : nullptr;
+}
+
+void Module::addSharedType(ObjectType &t)
+{
+    typeIndex[t.getSymbol()] = TypeEntry{&t, true};
+}
+
+uint64_t Module::getInterfaceHash()
+{
+    Hasher h;
+    for (auto &f : functions) {
+        if (!f->hasTrait(FunctionNode::PUBLIC))
+            continue;
+        h.add(f->getID());
+        h.add(f->getReturnType().getName());
+        h.add(std::to_string(f->getTraits()));
+    }
+    for (auto t : getObjectTypes()) {
+        h.add(t->getName());
+        for (auto &field : t->getFields()) {
+            h.add(field.first);
+            h.add(field.second->getName());
+        }
+    }
+    return h.get();
+}
+
+string Module::nameOf(const string &fileName)
 {
-    ///if its a primive fcall find the function by name
-    return std::find_if(ITER_THROUGH(functions), [&e](auto &f) { return e == f->getFunctionID(); });
+    auto begin = fileName.find_last_of("/\\");
+    begin = begin == string::npos ? 0 : begin + 1;
+    auto end = fileName.find('.', begin);
+    return fileName.substr(begin, end == string::npos ? string::npos : end - begin);
 }
 
-vector<Type *>::iterator Module::findType(string name)
+string Module::directoryOf(const string &fileName)
 {
-    return std::find_if(ITER_THROUGH(types),
-                        std::function([&name](auto &t) { return t->getName() == name; }));
+    auto end = fileName.find_last_of("/\\");
+    return end == string::npos ? "" : fileName.substr(0, end + 1);
 }
 
 void Module::addObjectType(unique_ptr<ObjectType> t)
 {
-    auto ptr = t.get();
-    t.release();
+    auto ptr = t.release();
     types.push_back(ptr);
+    typeIndex[ptr->getSymbol()] = TypeEntry{ptr, false};
 }
 } // namespace kvantum
@@ -1,6 +1,8 @@
 #pragma once
 #include "ast/ast.hpp"
 #include "ast/functionnode.hpp"
+#include <unordered_map>
+#include <unordered_set>
 
 namespace kvantum {
 class Compiler;
@@ -8,38 +10,82 @@ class Compiler;
 class Module
 {
 public:
-    Module(const string &n);
+    Module(const string &n, const string &fileName = "");
     ~Module();
 
     void addFunction(unique_ptr<FunctionNode> f);
     void addObjectType(unique_ptr<ObjectType> t);
+    ///makes a type owned elsewhere, like the list types, visible in the module
+    void addSharedType(ObjectType &t);
     void addExternalFunctionDependency(string moduleName, string functionName);
     void addExternalObjectDependency(string modusleName, string typen);
+    void addDependency(const string &moduleName);
 
     ObjectType &getObject(string name);
     Type &getType(string name);
+    Type &getType(SymbolID name);
     FunctionNode *getFunction(const FunctionNode::FunctionIdentifier id);
     vector<FunctionNode *> getFunctionGroup(string name);
 
     bool hasFunction(const FunctionNode::FunctionIdentifier id);
     bool hasType(string name);
+    bool hasType(SymbolID name);
     bool hasInternalFunction(string name);
     bool hasInternalType(string name);
 
     vector<ObjectType *> getObjectTypes();
     vector<FunctionNode *> getFunctions();
+    bool isExternalFunction(FunctionNode *f) { return externalFunctions.count(f) > 0; }
+    ///imported functions in import order
+    const vector<FunctionNode *> &getExternalFunctions() const { return importedFunctions; }
+    ///names of the modules this module imports from, in import order
+    const vector<string> &getDependencies() const { return dependencies; }
 
     string getName();
+    const string &getFileName() const { return fileName; }
+    /// hash of everything importers can see: public function signatures and object layouts
+    uint64_t getInterfaceHash();
     FunctionNode *getMainFunction();
+    ///modules loaded from an interface file have no function bodies to check or generate
+    bool isInterfaceOnly() const { return interfaceOnly; }
+    void setInterfaceOnly() { interfaceOnly = true; }
+    AstArena &getArena() { return arena; }
+    DiagnosticContext &getDiagnostics() { return diagnostics; }
+
+    /// module name of a source file, its file name without directory and extension
+    static string nameOf(const string &fileName);
+    /// directory part of a file name including the trailing separator
+    static string directoryOf(const string &fileName);
 
 private:
-    vector<FunctionNode *>::iterator findFunction(const FunctionNode::FunctionIdentifier &e);
-    vector<Type *>::iterator findType(string name);
+    FunctionNode *findFunction(const FunctionNode::FunctionIdentifier &e);
+    ///returns false if the function was already indexed
+    bool indexFunction(FunctionNode *f);
+    Type *findType(SymbolID name);
+
+    struct TypeEntry
+    {
+        Type *type;
+        bool external;
+    };
 
+    ///owns every AST node of the module, declared first so its released after the functions
+    AstArena arena;
+    DiagnosticContext diagnostics;
     string name;
+    string fileName;
+    ///types declared in the module in declaration order, starting with the builtin ones
     vector<Type *> types;
+    std::unordered_map<SymbolID, TypeEntry> typeIndex;
+    ///functions declared in the module in declaration order
     vector<unique_ptr<FunctionNode>> functions;
-    unsigned int externalFunctionIndex;
-    unsigned int externalTypeIndex;
+    std::unordered_set<FunctionNode *> externalFunctions;
+    vector<FunctionNode *> importedFunctions;
+    ///overload sets by name and candidates by signature hash, both hold internal and imported functions
+    std::unordered_map<SymbolID, vector<FunctionNode *>> overloads;
+    std::unordered_map<size_t, vector<FunctionNode *>> signatures;
+    std::unordered_set<SymbolID> internalFunctionNames;
+    vector<string> dependencies;
+    bool interfaceOnly = false;
 };
 } // namespace kvantum
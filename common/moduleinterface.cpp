@@ -0,0 +1,310 @@
+#include "common/moduleinterface.hpp"
+#include "common/compiler.hpp"
+#include "lexer/sourcebuffer.hpp"
+#include <cstring>
+
+using kvantum::lexer::SourceBuffer;
+
+namespace kvantum {
+
+/*
+    layout, integers are little endian u32 and strings are length prefixed:
+        magic, dependency names, object types (name, parent),
+        fields of every object type, public functions (name, traits, parent, return type, params)
+    types are written as a tag followed by the owning module and the name for named types
+    or the item type for derived types
+*/
+static constexpr char MAGIC[4] = {'K', 'V', 'I', 1};
+
+///primitives and Object, which every module shares
+static Type *findBuiltin(const string &name)
+{
+    if (name == ObjectType::getObject().getName())
+        return &ObjectType::getObject();
+    for (auto t : PrimitiveType::getTypes()) {
+        if (t->getName() == name)
+            return t;
+    }
+    return nullptr;
+}
+
+enum TypeTag : uint8_t { BUILTIN, NAMED, REFERENCE, ARRAY, LIST };
+
+namespace {
+
+class InterfaceWriter
+{
+public:
+    explicit InterfaceWriter(Module &mod)
+        : mod(mod)
+    {}
+
+    void writeMagic() { buffer.append(MAGIC, sizeof(MAGIC)); }
+    void writeU8(uint8_t v) { buffer.push_back((char) v); }
+    void writeU32(uint32_t v)
+    {
+        for (int i = 0; i < 4; i++)
+            writeU8((v >> (i * 8)) & 0xff);
+    }
+    void writeString(const string &s)
+    {
+        writeU32(s.size());
+        buffer += s;
+    }
+
+    ///false if the type belongs to a module the interface cannot refer to
+    bool writeType(Type &type)
+    {
+        if (type.isPrimitive() || &type == &ObjectType::getObject()) {
+            writeU8(BUILTIN);
+            writeString(type.getName());
+            return true;
+        }
+        if (type.isReference()) {
+            writeU8(REFERENCE);
+            return writeType(type.asReference().getReferencedType());
+        }
+        if (type.isArray()) {
+            writeU8(ARRAY);
+            return writeType(type.asArray().getType());
+        }
+        if (auto list = dynamic_cast<ListType *>(&type)) {
+            writeU8(LIST);
+            return writeType(list->getItemType());
+        }
+        auto owner = ownerOf(type.asObject());
+        if (!owner)
+            return false;
+        writeU8(NAMED);
+        writeString(*owner);
+        writeString(type.getName());
+        return true;
+    }
+
+    string &getBuffer() { return buffer; }
+
+private:
+    optional<string> ownerOf(ObjectType &type)
+    {
+        if (mod.hasInternalType(type.getName()) && &mod.getType(type.getSymbol()) == &type)
+            return mod.getName();
+        for (auto &dep : mod.getDependencies()) {
+            if (Compiler::Instance().hasObject(dep, type.getName())
+                && &Compiler::Instance().getObject(dep, type.getName()) == &type)
+                return dep;
+        }
+        return {};
+    }
+
+    Module &mod;
+    string buffer;
+};
+
+class InterfaceReader
+{
+public:
+    InterfaceReader(string_view data, Module &mod)
+        : data(data)
+        , mod(mod)
+    {}
+
+    bool readMagic()
+    {
+        return take(sizeof(MAGIC)) && !memcmp(&data[pos - sizeof(MAGIC)], MAGIC, sizeof(MAGIC));
+    }
+    uint8_t readU8() { return take(1) ? (uint8_t) data[pos - 1] : 0; }
+    uint32_t readU32()
+    {
+        if (!take(4))
+            return 0;
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++)
+            v |= (uint32_t) (uint8_t) data[pos - 4 + i] << (i * 8);
+        return v;
+    }
+    string readString()
+    {
+        uint32_t size = readU32();
+        if (!take(size))
+            return "";
+        return string(data.substr(pos - size, size));
+    }
+
+    Type *readType()
+    {
+        switch (readU8()) {
+        case BUILTIN:
+            return findBuiltin(readString());
+        case REFERENCE: {
+            Type *t = readType();
+            return t ? &ReferenceType::get(*t) : nullptr;
+        }
+        case ARRAY: {
+            Type *t = readType();
+            return t ? &ArrayType::get(*t) : nullptr;
+        }
+        case LIST: {
+            Type *t = readType();
+            return t ? &ListType::get(*t) : nullptr;
+        }
+        case NAMED: {
+            string owner = readString();
+            string name = readString();
+            if (failed)
+                return nullptr;
+            if (owner == mod.getName())
+                return mod.hasInternalType(name) ? &mod.getType(name) : nullptr;
+            ///types of other modules are resolved the same way a use directive would
+            Compiler::Instance().requireModule(owner, Module::directoryOf(mod.getFileName()) + owner + ".kv");
+            if (!Compiler::Instance().hasObject(owner, name))
+                return nullptr;
+            return &Compiler::Instance().getObject(owner, name);
+        }
+        default:
+            failed = true;
+            return nullptr;
+        }
+    }
+
+    bool hasFailed() const { return failed; }
+    bool atEnd() const { return pos == data.size(); }
+
+private:
+    bool take(size_t n)
+    {
+        if (failed || n > data.size() - pos) {
+            failed = true;
+            return false;
+        }
+        pos += n;
+        return true;
+    }
+
+    string_view data;
+    size_t pos = 0;
+    bool failed = false;
+    Module &mod;
+};
+
+} // namespace
+
+optional<string> ModuleInterface::serialize(Module &mod)
+{
+    InterfaceWriter w(mod);
+    w.writeMagic();
+
+    w.writeU32(mod.getDependencies().size());
+    for (auto &dep : mod.getDependencies())
+        w.writeString(dep);
+
+    auto objects = mod.getObjectTypes();
+    w.writeU32(objects.size());
+    for (auto t : objects) {
+        w.writeString(t->getName());
+        if (!w.writeType(t->getParent() ? *t->getParent() : ObjectType::getObject()))
+            return {};
+    }
+    for (auto t : objects) {
+        auto &fields = t->getNode()->fields;
+        w.writeU32(fields.size());
+        for (auto &field : fields) {
+            w.writeString(field.first);
+            if (!w.writeType(*field.second))
+                return {};
+        }
+    }
+
+    vector<FunctionNode *> functions;
+    for (auto f : mod.getFunctions()) {
+        if (f->hasTrait(FunctionNode::PUBLIC))
+            functions.push_back(f);
+    }
+    w.writeU32(functions.size());
+    for (auto f : functions) {
+        w.writeString(f->getName());
+        w.writeU8(f->getTraits());
+        if (!w.writeType(f->getParent()) || !w.writeType(f->getReturnType()))
+            return {};
+        ///self is inserted again when the loaded method is added to its type
+        bool self = f->isMethod() && !f->hasTrait(FunctionNode::STATIC);
+        w.writeU32(f->formalParams.size() - self);
+        for (size_t i = self; i < f->formalParams.size(); i++) {
+            w.writeString(f->formalParams[i]->id);
+            if (!w.writeType(f->formalParams[i]->getType()))
+                return {};
+        }
+    }
+    return std::move(w.getBuffer());
+}
+
+unique_ptr<Module> ModuleInterface::load(const string &name,
+                                         const string &fileName,
+                                         const string &path)
+{
+    auto file = SourceBuffer::open(path);
+    if (!file)
+        return nullptr;
+
+    auto mod = std::make_unique<Module>(name, fileName);
+    mod->setInterfaceOnly();
+    AstArena::Activation arena(mod->getArena());
+    InterfaceReader r(file->getText(), *mod);
+    if (!r.readMagic())
+        return nullptr;
+
+    for (uint32_t n = r.readU32(); n > 0 && !r.hasFailed(); n--)
+        mod->addDependency(r.readString());
+
+    vector<ObjectType *> objects;
+    for (uint32_t n = r.readU32(); n > 0 && !r.hasFailed(); n--) {
+        string typeName = r.readString();
+        Type *parent = r.readType();
+        if (!parent || !parent->isObject())
+            return nullptr;
+        auto t = std::make_unique<ObjectType>(new TypeNode(typeName),
+                                              parent == &ObjectType::getObject() ? nullptr
+                                                                                 : &parent->asObject());
+        objects.push_back(t.get());
+        mod->addObjectType(std::move(t));
+    }
+    for (auto t : objects) {
+        for (uint32_t n = r.readU32(); n > 0 && !r.hasFailed(); n--) {
+            string field = r.readString();
+            Type *type = r.readType();
+            if (!type)
+                return nullptr;
+            t->getNode()->fields.emplace(field, type);
+        }
+    }
+
+    for (uint32_t n = r.readU32(); n > 0 && !r.hasFailed(); n--) {
+        string funcName = r.readString();
+        unsigned char traits = r.readU8();
+        Type *parent = r.readType();
+        Type *returnType = r.readType();
+        if (!parent || !returnType)
+            return nullptr;
+        vector<Variable *> params;
+        for (uint32_t p = r.readU32(); p > 0 && !r.hasFailed(); p--) {
+            string param = r.readString();
+            Type *type = r.readType();
+            if (!type)
+                return nullptr;
+            params.push_back(make_node<Variable>(SymbolTable::intern(param), *type));
+        }
+        auto func = std::make_unique<FunctionNode>(funcName, *returnType, params, vector<Statement *>{},
+                                                   *parent, traits);
+        if (func->isMethod()) {
+            if (!parent->isObject())
+                return nullptr;
+            parent->asObject().addFunction(funcName, func.get());
+        }
+        mod->addFunction(std::move(func));
+    }
+
+    if (r.hasFailed() || !r.atEnd())
+        return nullptr;
+    return mod;
+}
+
+} // namespace kvantum
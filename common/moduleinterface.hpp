@@ -0,0 +1,21 @@
+#pragma once
+#include "module.hpp"
+
+namespace kvantum {
+
+/*
+    binary interface of a module, holds what importers can see:
+    the public function signatures and the object type layouts.
+    loading an interface builds a body-less module, so importing a module
+    which did not change costs reading its interface instead of parsing it
+*/
+class ModuleInterface
+{
+public:
+    /// serializes the interface of a type checked module, nothing if it refers to a type it cannot name
+    static optional<string> serialize(Module &mod);
+    /// maps the interface file and builds the module from it, nullptr if its missing or malformed
+    static unique_ptr<Module> load(const string &name, const string &fileName, const string &path);
+};
+
+} // namespace kvantum
@@ -0,0 +1,61 @@
+#include "common/symbol.hpp"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace kvantum {
+
+namespace {
+struct Storage
+{
+    std::shared_mutex mutex;
+    ///a deque never moves its elements, so the index can key on views into it
+    std::deque<string> names;
+    std::unordered_map<std::string_view, SymbolID> index;
+};
+
+Storage &storage()
+{
+    static Storage s;
+    return s;
+}
+} // namespace
+
+SymbolID SymbolTable::intern(std::string_view name)
+{
+    Storage &s = storage();
+    {
+        std::shared_lock<std::shared_mutex> lock(s.mutex);
+        auto iter = s.index.find(name);
+        if (iter != s.index.end())
+            return iter->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(s.mutex);
+    auto iter = s.index.find(name);
+    if (iter != s.index.end())
+        return iter->second;
+    SymbolID id = (SymbolID) s.names.size();
+    s.names.emplace_back(name);
+    s.index.emplace(s.names.back(), id);
+    return id;
+}
+
+const string &SymbolTable::getName(SymbolID id)
+{
+    static const string none;
+    if (id == NO_SYMBOL)
+        return none;
+    Storage &s = storage();
+    std::shared_lock<std::shared_mutex> lock(s.mutex);
+    return s.names[id];
+}
+
+size_t SymbolTable::size()
+{
+    Storage &s = storage();
+    std::shared_lock<std::shared_mutex> lock(s.mutex);
+    return s.names.size();
+}
+
+} // namespace kvantum
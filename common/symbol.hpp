@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using std::string;
+
+namespace kvantum {
+
+using SymbolID = uint32_t;
+
+/*
+    global interner of identifiers and type names
+    every distinct name is mapped to a 32 bit id once, so name resolution
+    can hash and compare integers instead of strings
+*/
+class SymbolTable
+{
+public:
+    static constexpr SymbolID NO_SYMBOL = UINT32_MAX;
+
+    /// returns the id of the name, registering it on first use, safe to call from any thread
+    static SymbolID intern(std::string_view name);
+    /// the returned reference stays valid for the whole compilation, NO_SYMBOL has an empty name
+    static const string &getName(SymbolID id);
+    static size_t size();
+};
+
+} // namespace kvantum
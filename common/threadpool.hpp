@@ -0,0 +1,43 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace kvantum {
+
+/*
+    fixed set of worker threads executing submitted tasks in submission order
+    tasks may submit further tasks, wait() returns once every task has finished
+*/
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int threadCount = defaultThreadCount());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(std::function<void()> task);
+    /// blocks until the queue is drained, rethrows the first exception thrown by a task
+    void wait();
+
+    static unsigned int defaultThreadCount();
+
+private:
+    void work();
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable idle;
+    unsigned int running = 0;
+    bool stopping = false;
+    std::exception_ptr failure;
+};
+
+} // namespace kvantum
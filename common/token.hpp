@@ -1,11 +1,13 @@
 #pragma once
+#include "common/symbol.hpp"
 #include "util.hpp"
 #include <string>
+#include <string_view>
 
 namespace kvantum {
 struct Token
 {
-    enum TokenType {
+    enum TokenType : uint8_t {
         INTEGER,
         RATIONAL,
         BOOLEAN,
@@ -57,15 +59,18 @@ struct Token
         FUNCTION_CALL
     };
 
-    Token(TokenType t, std::string str, std::string file = "", int lineIndex = 0)
+    static constexpr uint16_t NO_FILE = UINT16_MAX;
+
+    Token(TokenType t, std::string_view str, uint16_t file = NO_FILE, unsigned int lineIndex = 0)
     {
         type = t;
         value = str;
         this->lineIndex = lineIndex;
-        filename = file;
+        fileID = file;
     }
     Token()
         : lineIndex(0)
+        , fileID(NO_FILE)
     {
         type = END_OF_FILE;
     }
@@ -132,9 +137,12 @@ struct Token
         return *this;
     }
 
+    ///points into the SourceBuffer of the file, which lives for the whole compilation
+    std::string_view value;
+    ///interned name of identifiers, NO_SYMBOL for every other token
+    SymbolID symbol = SymbolTable::NO_SYMBOL;
+    unsigned int lineIndex;
+    uint16_t fileID;
     TokenType type;
-    std::string value;
-    std::string filename;
-    int lineIndex;
 };
 } // namespace kvantum
@@ -2,25 +2,13 @@
 #include "ast/ast.hpp"
 #include "common/compiler.hpp"
 #include <iterator>
+#include <mutex>
 #include <optional>
 
 namespace kvantum {
 
 /*  Type methods  */
 
-template<typename T>
-std::optional<typename vector<T>::iterator> find(typename vector<T>::iterator begin,
-                                                 typename vector<T>::iterator end,
-                                                 T item)
-{
-    while (begin != end) {
-        if (*begin == item)
-            return begin;
-        begin++;
-    }
-    return {};
-}
-
 void Type::initialize()
 {
     PrimitiveType::initialize();
@@ -29,12 +17,21 @@ void Type::initialize()
 
 Type& Type::get(string name)
 {
-    std::vector<string> type_str = {"Int", "Float", "Bool", "Char", "Void"};
-    auto tp = kvantum::find(type_str.begin(), type_str.end(), name);
-    if (tp.has_value())
-        return PrimitiveType::get(
-            static_cast<PrimitiveType::TypeBase>(std::distance(type_str.begin(), tp.value())));
-    throw std::invalid_argument("no type named " + name);
+    return get(SymbolTable::intern(name));
+}
+
+Type& Type::get(SymbolID name)
+{
+    auto iter = builtinTypes().find(name);
+    if (iter != builtinTypes().end())
+        return *iter->second;
+    throw std::invalid_argument("no type named " + SymbolTable::getName(name));
+}
+
+std::unordered_map<SymbolID, Type*>& Type::builtinTypes()
+{
+    static std::unordered_map<SymbolID, Type*> types;
+    return types;
 }
 
 PrimitiveType& Type::asPrimitive()
@@ -64,12 +61,19 @@ string PrimitiveType::getName() const
 
 void PrimitiveType::initialize()
 {
-    for (unsigned int i = 0; i < types.size(); i++)
+    for (unsigned int i = 0; i < types.size(); i++) {
         types[i] = std::make_unique<PrimitiveType>((TypeBase) i);
+        builtinTypes().emplace(types[i]->getSymbol(), types[i].get());
+    }
 }
 
 /*  ObjectType methods  */
 
+bool Type::isAssignableTo(Type& target)
+{
+    return *this == target || (isObject() && target.isObject() && asObject().derivesFrom(target.asObject()));
+}
+
 bool ObjectType::equals(Type& other) const
 {
     if (&getObject() == this)
@@ -77,6 +81,14 @@ bool ObjectType::equals(Type& other) const
     return other.isObject() && other.asObject().getNode() == node;
 }
 
+bool ObjectType::derivesFrom(ObjectType& base)
+{
+    for (ObjectType* t = parent; t; t = t->parent)
+        if (t->equals(base))
+            return true;
+    return false;
+}
+
 unsigned int ObjectType::getAllocSize()
 {
     unsigned int sz = 0;
@@ -155,15 +167,15 @@ void ObjectType::addFunction(string name, FunctionNode* fnode)
 
     //if not static append the self ptr to arguments
     if (!fnode->hasTrait(FunctionNode::STATIC))
-        fnode->formalParams.insert(fnode->formalParams.begin(), new Variable("self", *this));
+        fnode->addParameter(make_node<Variable>("self", *this), true);
 
     //for cctor we need to alloc memory and return self
     if (name == "new") {
         fnode->ast.insert(fnode->ast.begin(),
-                          new Assigment(new Variable("self", *this),
-                                        new DynamicAllocation(*this),
-                                        true));
-        fnode->ast.push_back(new Return(new Variable("self", *this)));
+                          make_node<Assigment>(make_node<Variable>("self", *this),
+                                               make_node<DynamicAllocation>(*this),
+                                               true));
+        fnode->ast.push_back(make_node<Return>(make_node<Variable>("self", *this)));
         fnode->setReturnType(*this);
     }
 }
@@ -197,10 +209,16 @@ void ObjectType::initialize()
     object = std::make_unique<ObjectType>(new TypeNode("Object"));
 }
 
+///the derived type caches are shared by the modules checked in parallel
+static std::mutex arraysMutex;
+static std::mutex listsMutex;
+static std::mutex referencesMutex;
+
 /* ArrayType methods */
 
 ArrayType& ArrayType::get(Type& itemT)
 {
+    std::lock_guard<std::mutex> lock(arraysMutex);
     auto iter = initiatedArrays.find(&itemT);
     if (iter != initiatedArrays.end())
         return *iter->second;
@@ -215,8 +233,11 @@ ListType::ListType(Type& t)
     : ObjectType(new TypeNode("[" + t.getName() + "]"))
     , type(t)
 {
+    ///list types are shared by every module so their methods cannot live in a module arena
+    AstArena::Activation arena(AstArena::global());
+
     auto accField = [this](string fieldname) {
-        return new FieldAccess(new Variable("self"), new Variable(fieldname));
+        return make_node<FieldAccess>(make_node<Variable>("self"), make_node<Variable>(fieldname));
     };
 
     node->fields.emplace("_arr", &ArrayType::get(t));
@@ -230,7 +251,7 @@ ListType::ListType(Type& t)
        */
     FunctionNode* reSize = new FunctionNode(getTypeID() + "_reSize",
                                             Type::get("Void"),
-                                            {new Variable("new_size", Type::get("Int"))});
+                                            {make_node<Variable>("new_size", Type::get("Int"))});
     reSize->setName(getName() + "_reSize");
     reSize->ast = {/*
                 arr = self._arr;
@@ -238,13 +259,17 @@ ListType::ListType(Type& t)
                 _c_builtin_::memcpy(self._arr,arr,self._size);
                 self.max_size = new_size;
            */
-                   new Assigment(new Variable("arr"), accField("_arr")),
-                   new Assigment(accField("_arr"),
-                                 new ArrayAllocation(type,
-                                                     new Variable("new_size", Type::get("Int")))),
-                   new FunctionCall(new Variable("memcpy"),
-                                    {accField("_arr"), new Variable("arr"), accField("size")}),
-                   new Assigment(accField("max_size"), new Variable("new_size", Type::get("Int")))};
+                   make_node<Assigment>(make_node<Variable>("arr"), accField("_arr")),
+                   make_node<Assigment>(accField("_arr"),
+                                        make_node<ArrayAllocation>(
+                                            type,
+                                            make_node<Variable>("new_size", Type::get("Int")))),
+                   make_node<FunctionCall>(make_node<Variable>("memcpy"),
+                                           vector<Expression*>{accField("_arr"),
+                                                               make_node<Variable>("arr"),
+                                                               accField("size")}),
+                   make_node<Assigment>(accField("max_size"),
+                                        make_node<Variable>("new_size", Type::get("Int")))};
     reSize->setTraitList(FunctionNode::PUBLIC);
 
     /*
@@ -252,7 +277,7 @@ ListType::ListType(Type& t)
        */
     FunctionNode* getSize = new FunctionNode(getTypeID() + "_getSize", Type::get("Int"));
     reSize->setName(getName() + "_getSize");
-    getSize->ast = {new Return(accField("size"))};
+    getSize->ast = {make_node<Return>(accField("size"))};
     getSize->setTraitList(FunctionNode::CONST | FunctionNode::PUBLIC);
 
     /*
@@ -260,7 +285,7 @@ ListType::ListType(Type& t)
        */
     FunctionNode* at = new FunctionNode(getTypeID() + "_at",
                                         type,
-                                        {new Variable("index", Type::get("Int"))});
+                                        {make_node<Variable>("index", Type::get("Int"))});
     at->setName(getName() + "_at");
     at->ast = {
 
@@ -273,14 +298,14 @@ ListType::ListType(Type& t)
        */
     FunctionNode* append = new FunctionNode(getTypeID() + "_append",
                                             Type::get("Void"),
-                                            {new Variable("item", type)});
+                                            {make_node<Variable>("item", type)});
     append->ast = {
         /*
                 if self.max_size == self.size:
                     self.reSize(self.max_size*2);
                 self.index(self.size+1) = item;
            */
-        //new If_Else(new BinaryOperation(accField()))
+        //make_node<If_Else>(make_node<BinaryOperation>(accField()))
     };
     append->setTraitList(FunctionNode::PUBLIC);
 
@@ -289,16 +314,18 @@ ListType::ListType(Type& t)
        */
     FunctionNode* cctor = new FunctionNode(getTypeID() + "_new",
                                            *this,
-                                           {new Variable("initializer", ArrayType::get(t)),
-                                            new Variable("arr_size", Type::get("Int"))});
+                                           {make_node<Variable>("initializer", ArrayType::get(t)),
+                                            make_node<Variable>("arr_size", Type::get("Int"))});
     reSize->setName(getName() + "_new");
     cctor->ast = {
         /*
                 self.size = 0;
                 self.reSize(arr_size);
            */
-        new Assigment(accField("size"), new Literal("0", Type::get("Int"))),
-        new FunctionCall(accField("reSize"), {new Variable("arr_size")}, reSize),
+        make_node<Assigment>(accField("size"), make_node<Literal>("0", Type::get("Int"))),
+        make_node<FunctionCall>(accField("reSize"),
+                                vector<Expression*>{make_node<Variable>("arr_size")},
+                                reSize),
     };
     cctor->setTraitList(FunctionNode::STATIC | FunctionNode::CONST | FunctionNode::PUBLIC);
 
@@ -309,6 +336,7 @@ ListType::ListType(Type& t)
 
 ListType& ListType::get(Type& t)
 {
+    std::lock_guard<std::mutex> lock(listsMutex);
     auto iter = initiatedLists.find(&t);
     if (iter != initiatedLists.end())
         return *iter->second;
@@ -320,6 +348,7 @@ ListType& ListType::get(Type& t)
 /* ReferenceType methods */
 ReferenceType& ReferenceType::get(Type& t)
 {
+    std::lock_guard<std::mutex> lock(referencesMutex);
     auto iter = initatedReferences.find(&t);
     if (iter != initatedReferences.end())
         return *iter->second;
@@ -1,9 +1,11 @@
 #pragma once
+#include "symbol.hpp"
 #include "util.hpp"
 #include <algorithm>
 #include <array>
 #include <map>
 #include <memory>
+#include <unordered_map>
 using std::map;
 using std::unique_ptr;
 
@@ -50,6 +52,8 @@ public:
     enum Trait { Public };
 
     virtual ~Type() = default;
+    ///types are compared by identity, assigning one would overwrite a shared instance
+    Type &operator=(const Type &) = delete;
     virtual string getName() const = 0;
     virtual string getTypeID() const { return getName(); }
     virtual bool isObject() const { return false; }
@@ -59,7 +63,11 @@ public:
     virtual bool isVoid() const { return false; }
     virtual bool equals(Type &other) const = 0;
     virtual bool weakEquals(Type &other) { return equals(other); }
+    ///an object can stand in for any of its parent types
+    bool isAssignableTo(Type &target);
     virtual unsigned int getAllocSize() = 0;
+    ///interned getName(), set once by the constructor of the concrete type
+    SymbolID getSymbol() const { return symbol; }
 
     PrimitiveType &asPrimitive();
     ObjectType &asObject();
@@ -70,10 +78,17 @@ public:
     static void initialize();
 
     static Type &get(string name);
+    static Type &get(SymbolID name);
     static unsigned int getPointerAllocSize() { return 4; }
 
     friend bool operator==(Type &l, Type &r) { return l.equals(r) || r.equals(l); }
     friend bool operator!=(Type &l, Type &r) { return !(l == r); }
+
+protected:
+    SymbolID symbol = SymbolTable::NO_SYMBOL;
+
+    ///function local, types are initialized by the static Compiler instance
+    static std::unordered_map<SymbolID, Type *> &builtinTypes();
 };
 
 class PrimitiveType : public Type
@@ -82,7 +97,9 @@ public:
     enum TypeBase { Integer, Float, Boolean, Char, Void };
     explicit PrimitiveType(TypeBase b)
         : type(b)
-    {}
+    {
+        symbol = SymbolTable::intern(getName());
+    }
 
     string getName() const override;
     bool isPrimitive() const override { return true; }
@@ -118,6 +135,7 @@ public:
     {
         this->node = node;
         this->parent = parent;
+        symbol = SymbolTable::intern(node->name);
     }
     ~ObjectType() override { delete node; }
 
@@ -126,6 +144,8 @@ public:
     string getName() const override { return node->name; }
     unsigned int getAllocSize() override;
     TypeNode *getNode() const { return node; }
+    ObjectType *getParent() const { return parent; }
+    bool derivesFrom(ObjectType &base);
 
     bool hasFunction(string name)
     {
@@ -169,7 +189,9 @@ public:
 private:
     ArrayType(Type &t)
         : type(t)
-    {}
+    {
+        symbol = SymbolTable::intern(getName());
+    }
     ~ArrayType() {}
     Type &type;
 
@@ -186,6 +208,7 @@ public:
     ListType(Type &t);
     static ListType &get(Type &t);
     string getTypeID() const override { return "[" + type.getName() + "]"; }
+    Type &getItemType() const { return type; }
 
 private:
     Type &type;
@@ -208,7 +231,9 @@ public:
 private:
     explicit ReferenceType(Type &refOf)
         : referenceOf(refOf)
-    {}
+    {
+        symbol = SymbolTable::intern(getName());
+    }
     Type &referenceOf;
     static map<Type *, ReferenceType *> initatedReferences;
 };
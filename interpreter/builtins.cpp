@@ -0,0 +1,191 @@
+#include "interpreter/builtins.hpp"
+#include "ast/functionnode.hpp"
+#include "interpreter/heap.hpp"
+#include <cstdio>
+#include <iostream>
+
+namespace kvantum::interpreter
+{
+    static const char* tagName(Value::Tag tag)
+    {
+        static const char* names[] = {"Void", "Int", "Float", "Bool", "String", "Array", "Object"};
+        return names[tag];
+    }
+
+    void NativeBuiltin::check(const Value* args) const
+    {
+        for (size_t i = 0; i < params.size(); i++) {
+            if (params[i] != Value::VOID && args[i].tag != params[i])
+                throw std::invalid_argument(name + " expects " + tagName(params[i]) + " for argument "
+                                            + std::to_string(i + 1) + " but got " + tagName(args[i].tag));
+        }
+    }
+
+    static string toString(const Value& v)
+    {
+        switch (v.tag) {
+        case Value::INT: return std::to_string(v.asInt());
+        case Value::RAT: return std::to_string(v.asRat());
+        case Value::BOOL: return v.asBool() ? "True" : "False";
+        case Value::STR: return v.asStr()->value;
+        default: return tagName(v.tag);
+        }
+    }
+
+    /*
+        %d and %i take an Int, %f a Float, %c an Int as character code,
+        %s prints any value and %% a single percent sign
+    */
+    static Value printf(const Value* args, unsigned int count)
+    {
+        const string& format = args[0].asStr()->value;
+        string out;
+        out.reserve(format.size());
+        unsigned int next = 1;
+        auto argument = [&](char spec) -> const Value& {
+            if (next >= count)
+                throw std::invalid_argument(string("printf is missing the argument for %") + spec);
+            return args[next++];
+        };
+        for (size_t i = 0; i < format.size(); i++) {
+            if (format[i] != '%' || i + 1 == format.size()) {
+                out += format[i];
+                continue;
+            }
+            char spec = format[++i];
+            switch (spec) {
+            case 'd':
+            case 'i': {
+                const Value& v = argument(spec);
+                if (!v.isInt())
+                    throw std::invalid_argument(string("printf expects Int for %") + spec);
+                out += std::to_string(v.asInt());
+                break;
+            }
+            case 'f': {
+                const Value& v = argument(spec);
+                if (!v.isRat() && !v.isInt())
+                    throw std::invalid_argument("printf expects Float for %f");
+                char buffer[64];
+                std::snprintf(buffer, sizeof(buffer), "%f", v.isRat() ? v.asRat() : v.asInt());
+                out += buffer;
+                break;
+            }
+            case 'c': {
+                const Value& v = argument(spec);
+                if (!v.isInt())
+                    throw std::invalid_argument("printf expects Int for %c");
+                out += (char) v.asInt();
+                break;
+            }
+            case 's':
+                out += toString(argument(spec));
+                break;
+            case '%':
+                out += '%';
+                break;
+            default:
+                throw std::invalid_argument(string("printf has no conversion %") + spec);
+            }
+        }
+        std::cout << out;
+        return Value((int) out.size());
+    }
+
+    ///the interpreter has no bytes, the size is the number of values
+    static Value malloc(const Value* args, unsigned int)
+    {
+        if (args[0].asInt() < 0)
+            throw std::invalid_argument("malloc of a negative size");
+        return Value(Heap::current().allocateArray(vector<Value>(args[0].asInt())));
+    }
+
+    static Value memcpy(const Value* args, unsigned int)
+    {
+        auto& dst = args[0].asArray()->values;
+        auto& src = args[1].asArray()->values;
+        int64_t n = args[2].asInt();
+        if (n < 0 || dst.size() < (size_t) n || src.size() < (size_t) n)
+            throw std::invalid_argument("memcpy of " + std::to_string(n) + " values out of range");
+        std::copy_n(src.begin(), n, dst.begin());
+        return args[0];
+    }
+
+    static Value strlen(const Value* args, unsigned int)
+    {
+        return Value((int) args[0].asStr()->value.size());
+    }
+
+    static Value substr(const Value* args, unsigned int)
+    {
+        const string& s = args[0].asStr()->value;
+        int64_t begin = args[1].asInt();
+        int64_t n = args[2].asInt();
+        if (begin < 0 || n < 0 || s.size() < (size_t) begin)
+            throw std::invalid_argument("substr out of range");
+        return Value(Heap::current().allocateString(s.substr(begin, n)));
+    }
+
+    static Value strcmp(const Value* args, unsigned int)
+    {
+        int order = args[0].asStr()->value.compare(args[1].asStr()->value);
+        return Value(order < 0 ? -1 : order > 0);
+    }
+
+    static Value atoi(const Value* args, unsigned int)
+    {
+        return Value((int64_t) std::strtoll(args[0].asStr()->value.c_str(), nullptr, 10));
+    }
+
+    static Value itoa(const Value* args, unsigned int)
+    {
+        return Value(Heap::current().allocateString(std::to_string(args[0].asInt())));
+    }
+
+    static Value len(const Value* args, unsigned int)
+    {
+        if (args[0].isArray())
+            return Value((int) args[0].asArray()->values.size());
+        if (args[0].isStr())
+            return Value((int) args[0].asStr()->value.size());
+        throw std::invalid_argument(string("len of ") + tagName(args[0].tag));
+    }
+
+    static Value push(const Value* args, unsigned int)
+    {
+        args[0].asArray()->values.push_back(args[1]);
+        return args[0];
+    }
+
+    VirtualFunctionInterpreter::VirtualFunctionInterpreter()
+    {
+        add("printf", printf, {Value::STR}, true);
+        add("malloc", malloc, {Value::INT});
+        add("memcpy", memcpy, {Value::ARRAY, Value::ARRAY, Value::INT});
+        add("strlen", strlen, {Value::STR});
+        add("substr", substr, {Value::STR, Value::INT, Value::INT});
+        add("strcmp", strcmp, {Value::STR, Value::STR});
+        add("atoi", atoi, {Value::STR});
+        add("itoa", itoa, {Value::INT});
+        add("len", len, {Value::VOID});
+        add("push", push, {Value::ARRAY, Value::VOID});
+    }
+
+    VirtualFunctionInterpreter::ID VirtualFunctionInterpreter::add(string name,
+                                                                   NativeFunction function,
+                                                                   vector<Value::Tag> params,
+                                                                   bool variadic)
+    {
+        if (ids.count(name))
+            throw std::invalid_argument("builtin " + name + " is already registered");
+        ID id = builtins.size();
+        ids.emplace(name, id);
+        builtins.push_back({std::move(name), function, std::move(params), variadic});
+        return id;
+    }
+
+    VirtualFunctionInterpreter::ID VirtualFunctionInterpreter::find(const FunctionNode* f) const
+    {
+        return f->hasTrait(FunctionNode::EXTERNAL) ? find(f->getName()) : NONE;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "interpreter/value.hpp"
+#include <unordered_map>
+
+namespace kvantum
+{
+    struct FunctionNode;
+}
+
+namespace kvantum::interpreter
+{
+    ///a builtin gets the arguments of the call in place, count is only needed by variadic ones
+    using NativeFunction = Value (*)(const Value* args, unsigned int count);
+
+    struct NativeBuiltin
+    {
+        string name;
+        NativeFunction function;
+        ///the tag of every fixed argument, VOID accepts any value
+        vector<Value::Tag> params;
+        ///any number of arguments of any kind can follow the fixed ones
+        bool variadic = false;
+
+        bool accepts(unsigned int count) const
+        {
+            return variadic ? count >= params.size() : count == params.size();
+        }
+        ///throws invalid_argument naming the first argument of the wrong kind
+        void check(const Value* args) const;
+    };
+
+    /*
+        functions the interpreters implement natively, calls of an [external] function bind to
+        the builtin of its name once and are dispatched through its id afterwards
+    */
+    class VirtualFunctionInterpreter
+    {
+    public:
+        using ID = uint16_t;
+        static constexpr ID NONE = UINT16_MAX;
+        ///the builtins every interpreter registers first, in this order
+        enum Standard : ID { PRINTF, MALLOC, MEMCPY, STRLEN, SUBSTR, STRCMP, ATOI, ITOA, LEN, PUSH };
+
+        VirtualFunctionInterpreter();
+
+        ID add(string name, NativeFunction function, vector<Value::Tag> params, bool variadic = false);
+        ///NONE if there is no builtin with the name
+        ID find(const string& name) const
+        {
+            auto iter = ids.find(name);
+            return iter != ids.end() ? iter->second : NONE;
+        }
+        ///NONE unless f is declared [external], a user function always shadows a builtin
+        ID find(const FunctionNode* f) const;
+        const NativeBuiltin& get(ID id) const { return builtins[id]; }
+
+        Value call(ID id, const Value* args, unsigned int count) const
+        {
+            const NativeBuiltin& builtin = builtins[id];
+            builtin.check(args);
+            return builtin.function(args, count);
+        }
+
+    private:
+        vector<NativeBuiltin> builtins;
+        std::unordered_map<string, ID> ids;
+    };
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include "interpreter/builtins.hpp"
+#include "interpreter/heap.hpp"
+#include "interpreter/inlinecache.hpp"
+#include "ast/functionnode.hpp"
+#include <unordered_map>
+
+namespace kvantum::interpreter
+{
+    /*
+        instructions of the register machine, a is the destination register
+        b and c are source registers unless noted otherwise
+    */
+#define KVANTUM_OPCODES(X) \
+    X(MOVE)     /* r[a] = r[b] */ \
+    X(LOADK)    /* r[a] = constants[b] */ \
+    X(ADD) X(SUB) X(MUL) X(DIV) \
+    X(EQ) X(NE) X(LT) X(LE) X(GT) X(GE) \
+    X(JMP)      /* jump to target */ \
+    X(JMPF)     /* jump to target if r[a] is false */ \
+    X(JMPT)     /* jump to target if r[a] is true */ \
+    X(CALL)     /* r[a] = functions[b](r[c], ...) */ \
+    X(TAILCALL) /* return functions[b](r[c], ...), reusing the frame */ \
+    X(CALLVIRT) /* r[a] = override of virtualCalls[b] for the type of r[c](r[c], ...) */ \
+    X(NATIVE)   /* r[a] = builtin natives[b].id(r[c], ...) */ \
+    X(INDEX)    /* r[a] = r[b][r[c]] */ \
+    X(NEWARRAY) /* r[a] = [r[b], ..., r[b + c - 1]] */ \
+    X(NEWOBJECT) /* r[a] = new object laid out by layouts[b] */ \
+    X(GETFIELD) /* r[a] = r[b].fields[c] */ \
+    X(SETFIELD) /* r[a].fields[b] = r[c] */ \
+    X(CAST)     /* r[a] = r[b] converted to the primitive type c */ \
+    X(RET)      /* return r[a] */ \
+    X(RETVOID)
+
+    enum class OpCode : uint8_t {
+#define KVANTUM_OPCODE_ENUM(name) name,
+        KVANTUM_OPCODES(KVANTUM_OPCODE_ENUM)
+#undef KVANTUM_OPCODE_ENUM
+    };
+
+    struct Instruction
+    {
+        OpCode op;
+        uint16_t a = 0;
+        uint16_t b = 0;
+        uint16_t c = 0;
+
+        ///jumps keep their target in b and c
+        static Instruction jump(OpCode op, uint16_t a, uint32_t target)
+        {
+            return {op, a, (uint16_t) (target & 0xffff), (uint16_t) (target >> 16)};
+        }
+        uint32_t target() const { return b | ((uint32_t) c << 16); }
+        void setTarget(uint32_t target)
+        {
+            b = target & 0xffff;
+            c = target >> 16;
+        }
+    };
+
+    /*
+        a function lowered to the register machine,
+        the parameters arrive in the first registers
+    */
+    struct BytecodeFunction
+    {
+        FunctionNode* source = nullptr;
+        vector<Instruction> code;
+        ///source line of every instruction, only read when reporting a runtime error
+        vector<unsigned int> lines;
+        vector<Value> constants;
+        unsigned int paramCount = 0;
+        unsigned int registerCount = 0;
+        bool compiled = false;
+    };
+
+    ///a builtin together with the number of arguments passed at the call site
+    struct NativeCall
+    {
+        VirtualFunctionInterpreter::ID id;
+        uint16_t argCount;
+
+        bool operator==(const NativeCall& other) const
+        {
+            return id == other.id && argCount == other.argCount;
+        }
+    };
+
+    ///a call site of a virtual method and the compiled overrides it dispatched to
+    struct VirtualCall
+    {
+        FunctionNode* method;
+        InlineCache<BytecodeFunction*> receivers;
+    };
+
+    /*
+        every function reachable from the entry point and the builtins they call,
+        functions get their index when first referenced and are compiled afterwards
+    */
+    struct Program
+    {
+        unsigned int indexOf(FunctionNode* f)
+        {
+            auto iter = functionIndex.find(f);
+            if (iter != functionIndex.end())
+                return iter->second;
+            functions.push_back(std::make_unique<BytecodeFunction>());
+            functions.back()->source = f;
+            functionIndex.emplace(f, functions.size() - 1);
+            return functions.size() - 1;
+        }
+
+        unsigned int layoutIndexOf(const ObjectLayout& layout)
+        {
+            auto iter = std::find(ITER_THROUGH(layouts), &layout);
+            if (iter != layouts.end())
+                return iter - layouts.begin();
+            layouts.push_back(&layout);
+            return layouts.size() - 1;
+        }
+
+        unsigned int addVirtualCall(FunctionNode* method)
+        {
+            virtualCalls.push_back(std::make_unique<VirtualCall>());
+            virtualCalls.back()->method = method;
+            return virtualCalls.size() - 1;
+        }
+
+        unsigned int nativeIndexOf(const NativeCall& call)
+        {
+            auto iter = std::find(ITER_THROUGH(natives), call);
+            if (iter != natives.end())
+                return iter - natives.begin();
+            natives.push_back(call);
+            return natives.size() - 1;
+        }
+
+        vector<unique_ptr<BytecodeFunction>> functions;
+        std::unordered_map<FunctionNode*, unsigned int> functionIndex;
+        vector<NativeCall> natives;
+        vector<const ObjectLayout*> layouts;
+        ///sites are added while others are being resolved, so they do not move
+        vector<unique_ptr<VirtualCall>> virtualCalls;
+    };
+}
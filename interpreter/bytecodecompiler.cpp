@@ -0,0 +1,298 @@
+#include "interpreter/bytecodecompiler.hpp"
+#include "interpreter/interpreter.hpp"
+#include "interpreter/slotresolver.hpp"
+
+namespace kvantum::interpreter
+{
+    ///fields are accessed the same way through a reference and through the object
+    static ObjectType& objectTypeOf(Type& type)
+    {
+        Type& object = type.isReference() ? type.asReference().getReferencedType() : type;
+        if (!object.isObject())
+            panic("cannot access a field of a non-object " + object.getName());
+        return object.asObject();
+    }
+
+    BytecodeCompiler::BytecodeCompiler(Program& program, VirtualFunctionInterpreter& builtins, ConstantPool& constants)
+        : program(program)
+        , builtins(builtins)
+        , constants(constants)
+    {
+    }
+
+    void BytecodeCompiler::compile(BytecodeFunction& func)
+    {
+        this->func = &func;
+        FunctionNode* node = func.source;
+        SlotResolver::resolve(node);
+        func.paramCount = node->formalParams.size();
+        func.registerCount = localCount = top = *node->frameSize;
+
+        for (auto& e : node->ast)
+            compileStatement(e);
+        ///falling off the end returns Void
+        emit({OpCode::RETVOID});
+        func.compiled = true;
+    }
+
+    uint16_t BytecodeCompiler::compileExpression(Expression* expr, int destination)
+    {
+        this->destination = destination;
+        return any_cast<uint16_t>(visit_expression(expr));
+    }
+
+    void BytecodeCompiler::compileStatement(Statement* st)
+    {
+        top = localCount;
+        destination = -1;
+        visit_statement(st);
+        top = localCount;
+    }
+
+    uint16_t BytecodeCompiler::takeDestination()
+    {
+        if (destination < 0)
+            return allocateRegister();
+        uint16_t reg = destination;
+        destination = -1;
+        return reg;
+    }
+
+    uint16_t BytecodeCompiler::allocateRegister()
+    {
+        KVANTUM_VERIFY(top < UINT16_MAX, "too many registers in " + func->source->getName());
+        func->registerCount = std::max(func->registerCount, top + 1);
+        return top++;
+    }
+
+    uint16_t BytecodeCompiler::registerOf(Variable* var)
+    {
+        if (var->slot == Variable::NO_SLOT)
+            panic("unresolved variable " + var->id);
+        return var->slot;
+    }
+
+    uint16_t BytecodeCompiler::addConstant(Value value)
+    {
+        func->constants.push_back(value);
+        return func->constants.size() - 1;
+    }
+
+    uint16_t BytecodeCompiler::compileArguments(const vector<Expression*>& args)
+    {
+        ///arguments are evaluated into consecutive registers, reserved before the temporaries of any of them
+        uint16_t base = top;
+        for (size_t i = 0; i < args.size(); i++)
+            allocateRegister();
+        for (size_t i = 0; i < args.size(); i++)
+            compileExpression(args[i], base + i);
+        return base;
+    }
+
+    std::pair<uint16_t, uint16_t> BytecodeCompiler::compileFieldBase(FieldAccess* access)
+    {
+        ///a.b.c nests to the right, every link but the last is loaded into a temporary
+        ObjectType* type = &objectTypeOf(access->base->getType());
+        uint16_t object = compileExpression(access->base);
+        Variable* field = access->field;
+        while (field->isField()) {
+            Variable* link = field->asField()->base->as<Variable*>();
+            uint16_t next = allocateRegister();
+            emit({OpCode::GETFIELD, next, object, ObjectLayout::of(*type).slotOf(link->symbol)});
+            type = &objectTypeOf(type->getFieldType(link->id));
+            object = next;
+            field = field->asField()->field;
+        }
+        return {object, ObjectLayout::of(*type).slotOf(field->symbol)};
+    }
+
+    void BytecodeCompiler::emit(Instruction in)
+    {
+        func->code.push_back(in);
+        func->lines.push_back(current ? current->lineIndex : 0);
+    }
+
+    size_t BytecodeCompiler::emitJump(OpCode op, uint16_t condition)
+    {
+        emit(Instruction::jump(op, condition, 0));
+        return func->code.size() - 1;
+    }
+
+    void BytecodeCompiler::patchJump(size_t jump)
+    {
+        func->code[jump].setTarget(func->code.size());
+    }
+
+    any BytecodeCompiler::visit(Literal* literal)
+    {
+        uint16_t dst = takeDestination();
+        emit({OpCode::LOADK, dst, addConstant(constants.get(literal))});
+        return dst;
+    }
+
+    any BytecodeCompiler::visit(BinaryOperation* bop)
+    {
+        uint16_t dst = takeDestination();
+        ///and, or short circuit, the result is built in a temporary so the operands can read dst
+        if (bop->op == BinaryOperation::AND || bop->op == BinaryOperation::OR) {
+            uint16_t result = allocateRegister();
+            compileExpression(bop->lhs, result);
+            size_t skip = emitJump(bop->op == BinaryOperation::AND ? OpCode::JMPF : OpCode::JMPT, result);
+            compileExpression(bop->rhs, result);
+            patchJump(skip);
+            emit({OpCode::MOVE, dst, result});
+            return dst;
+        }
+
+        uint16_t l = compileExpression(bop->lhs);
+        uint16_t r = compileExpression(bop->rhs);
+        static const OpCode ops[] = {OpCode::ADD, OpCode::SUB, OpCode::MUL, OpCode::DIV,
+                                     OpCode::EQ,  OpCode::NE,  OpCode::LT,  OpCode::LE,
+                                     OpCode::GT,  OpCode::GE};
+        emit({ops[bop->op], dst, l, r});
+        return dst;
+    }
+
+    any BytecodeCompiler::visit(Variable* var)
+    {
+        if (var->isField()) {
+            uint16_t dst = takeDestination();
+            auto [object, slot] = compileFieldBase(var->asField());
+            emit({OpCode::GETFIELD, dst, object, slot});
+            return dst;
+        }
+        uint16_t reg = registerOf(var);
+        if (destination < 0)
+            return reg;
+        uint16_t dst = takeDestination();
+        if (dst != reg)
+            emit({OpCode::MOVE, dst, reg});
+        return dst;
+    }
+
+    any BytecodeCompiler::visit(DynamicAllocation* alloc)
+    {
+        uint16_t dst = takeDestination();
+        if (alloc->node.isObject()) {
+            auto layout = program.layoutIndexOf(ObjectLayout::of(alloc->node.asObject()));
+            emit({OpCode::NEWOBJECT, dst, (uint16_t) layout});
+            return dst;
+        }
+        uint16_t base = compileArguments({alloc->sizeExpr});
+        emit({OpCode::NATIVE, dst, (uint16_t) program.nativeIndexOf({VirtualFunctionInterpreter::MALLOC, 1}), base});
+        return dst;
+    }
+
+    any BytecodeCompiler::visit(ArrayExpression* arr)
+    {
+        uint16_t dst = takeDestination();
+        uint16_t base = compileArguments({ITER_THROUGH(arr->initializer)});
+        emit({OpCode::NEWARRAY, dst, base, (uint16_t) arr->initializer.size()});
+        return dst;
+    }
+
+    any BytecodeCompiler::visit(FunctionCall* fcall)
+    {
+        uint16_t dst = takeDestination();
+        uint16_t base = compileArguments(fcall->arguments);
+        auto builtin = builtins.find(fcall->fnode);
+        if (builtin != VirtualFunctionInterpreter::NONE) {
+            NativeCall call{builtin, (uint16_t) fcall->arguments.size()};
+            KVANTUM_VERIFY(builtins.get(builtin).accepts(call.argCount),
+                           "wrong number of arguments for " + fcall->fnode->getName());
+            emit({OpCode::NATIVE, dst, (uint16_t) program.nativeIndexOf(call), base});
+        } else if (isVirtualCall(fcall->fnode))
+            emit({OpCode::CALLVIRT, dst, (uint16_t) program.addVirtualCall(fcall->fnode), base});
+        else
+            emit({OpCode::CALL, dst, (uint16_t) program.indexOf(fcall->fnode), base});
+        return dst;
+    }
+
+    any BytecodeCompiler::visit(ArrayIndex* ind)
+    {
+        uint16_t dst = takeDestination();
+        uint16_t base = compileExpression(ind->baseArray);
+        uint16_t index = compileExpression(ind->index);
+        emit({OpCode::INDEX, dst, base, index});
+        return dst;
+    }
+
+    any BytecodeCompiler::visit(TakeReference* ref)
+    {
+        ///values are shared, a reference is the value itself
+        return compileExpression(ref->baseExpr, destination);
+    }
+
+    any BytecodeCompiler::visit(Cast* cast)
+    {
+        uint16_t dst = takeDestination();
+        uint16_t src = compileExpression(cast->expr);
+        if (cast->castTo.isPrimitive())
+            emit({OpCode::CAST, dst, src, (uint16_t) cast->castTo.asPrimitive().type});
+        else
+            emit({OpCode::MOVE, dst, src});
+        return dst;
+    }
+
+    void BytecodeCompiler::visit(Assigment* assig)
+    {
+        if (assig->variable->isField()) {
+            uint16_t value = compileExpression(assig->expr);
+            auto [object, slot] = compileFieldBase(assig->variable->asField());
+            emit({OpCode::SETFIELD, object, slot, value});
+            return;
+        }
+        ///a declaration only differs by its register, which the resolver already picked
+        compileExpression(assig->expr, registerOf(assig->variable));
+    }
+
+    void BytecodeCompiler::visit(If_Else* if_else)
+    {
+        uint16_t cond = compileExpression(if_else->condition);
+        size_t skipIf = emitJump(OpCode::JMPF, cond);
+        compileStatement(if_else->ifBlock);
+        if (if_else->elseBlock) {
+            size_t skipElse = emitJump(OpCode::JMP);
+            patchJump(skipIf);
+            compileStatement(if_else->elseBlock);
+            patchJump(skipElse);
+        } else
+            patchJump(skipIf);
+    }
+
+    void BytecodeCompiler::visit(While* while_loop)
+    {
+        uint32_t begin = func->code.size();
+        uint16_t cond = compileExpression(while_loop->condition);
+        size_t exit = emitJump(OpCode::JMPF, cond);
+        compileStatement(while_loop->block);
+        emit(Instruction::jump(OpCode::JMP, 0, begin));
+        patchJump(exit);
+    }
+
+    void BytecodeCompiler::visit(Return* ret)
+    {
+        ///a direct call in tail position replaces the frame of this function
+        if (ret->expr && ret->expr->exprtype == ExprType::FUNCTION_CALL) {
+            auto fcall = static_cast<FunctionCall*>(ret->expr);
+            if (builtins.find(fcall->fnode) == VirtualFunctionInterpreter::NONE
+                && !isVirtualCall(fcall->fnode)) {
+                uint16_t base = compileArguments(fcall->arguments);
+                emit({OpCode::TAILCALL, 0, (uint16_t) program.indexOf(fcall->fnode), base});
+                return;
+            }
+        }
+        if (ret->expr)
+            emit({OpCode::RET, compileExpression(ret->expr)});
+        else
+            emit({OpCode::RETVOID});
+    }
+
+    void BytecodeCompiler::visit(StatementBlock* block)
+    {
+        for (auto& e : block->block)
+            compileStatement(e);
+    }
+
+    void BytecodeCompiler::visit(For* f) {}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "interpreter/bytecode.hpp"
+#include "interpreter/constantpool.hpp"
+#include "ast/treevisitor.hpp"
+
+namespace kvantum::interpreter
+{
+    /*
+        lowers a type checked function to register machine instructions,
+        the frame slots of the locals are their registers and temporaries are
+        allocated above them and released after every statement
+    */
+    class BytecodeCompiler : public TreeVisitor
+    {
+    IMPLEMENTS_TREE_VISITOR
+    public:
+        BytecodeCompiler(Program& program, VirtualFunctionInterpreter& builtins, ConstantPool& constants);
+        void compile(BytecodeFunction& func);
+
+    private:
+        ///evaluates the expression into the destination register or any register if there is none
+        uint16_t compileExpression(Expression* expr, int destination = -1);
+        void compileStatement(Statement* st);
+        ///the destination requested by the caller, or a new temporary
+        uint16_t takeDestination();
+        uint16_t allocateRegister();
+        uint16_t registerOf(Variable* var);
+        uint16_t addConstant(Value value);
+        uint16_t compileArguments(const vector<Expression*>& args);
+        ///loads the object holding the last field of the chain, returns its register and the field slot
+        std::pair<uint16_t, uint16_t> compileFieldBase(FieldAccess* access);
+
+        void emit(Instruction in);
+        ///emits a jump with an unknown target and returns its position for patchJump
+        size_t emitJump(OpCode op, uint16_t condition = 0);
+        void patchJump(size_t jump);
+
+        Program& program;
+        VirtualFunctionInterpreter& builtins;
+        ConstantPool& constants;
+        BytecodeFunction* func = nullptr;
+        ///registers below localCount hold locals, temporaries are allocated from top
+        unsigned int localCount = 0;
+        unsigned int top = 0;
+        int destination = -1;
+    };
+}
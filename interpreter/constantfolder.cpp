@@ -0,0 +1,201 @@
+#include "interpreter/constantfolder.hpp"
+#include "common/diagnostics.hpp"
+#include <cmath>
+#include <cstdio>
+
+namespace kvantum::interpreter
+{
+    ConstantFolder::ConstantFolder()
+    {
+        vm.setMaxCallDepth(MAX_CALL_DEPTH);
+    }
+
+    void ConstantFolder::fold(Module* mod)
+    {
+        AstArena::Activation arena(mod->getArena());
+        DiagnosticContext::Activation diagnostics(mod->getDiagnostics());
+        for (auto& f : mod->getFunctions())
+            for (auto& e : f->ast)
+                foldStatement(e);
+    }
+
+    Expression* ConstantFolder::fold(Expression* expr)
+    {
+        return expr ? any_cast<Expression*>(visit_expression(expr)) : nullptr;
+    }
+
+    void ConstantFolder::foldStatement(Statement* st)
+    {
+        if (st)
+            visit_statement(st);
+    }
+
+    bool ConstantFolder::isPure(FunctionNode* f)
+    {
+        auto iter = purity.find(f);
+        if (iter != purity.end())
+            return iter->second;
+        if (!f->hasTrait(FunctionNode::EXPRESSION) || f->isMethod() || f->ast.size() != 1
+            || builtins.find(f) != VirtualFunctionInterpreter::NONE)
+            return purity[f] = false;
+        ///a recursive call is pure if the rest of the function is
+        purity[f] = true;
+        auto ret = f->ast[0]->sttype == StatementType::RETURN ? static_cast<Return*>(f->ast[0]) : nullptr;
+        return purity[f] = ret && ret->expr && isPure(ret->expr);
+    }
+
+    bool ConstantFolder::isPure(Expression* expr)
+    {
+        switch (expr->exprtype) {
+        case ExprType::LITERAL:
+            return true;
+        case ExprType::VARIABLE:
+            return !static_cast<Variable*>(expr)->isField();
+        case ExprType::BINARY_OPERATION: {
+            auto bop = static_cast<BinaryOperation*>(expr);
+            return isPure(bop->lhs) && isPure(bop->rhs);
+        }
+        case ExprType::CAST:
+            return isPure(static_cast<Cast*>(expr)->expr);
+        case ExprType::FUNCTION_CALL: {
+            auto fcall = static_cast<FunctionCall*>(expr);
+            return fcall->fnode && isPure(fcall->fnode)
+                   && std::all_of(ITER_THROUGH(fcall->arguments), [this](Expression* e) { return isPure(e); });
+        }
+        default:
+            return false;
+        }
+    }
+
+    Literal* ConstantFolder::toLiteral(const Value& v, Type& type)
+    {
+        if (!type.isPrimitive())
+            return nullptr;
+        auto base = type.asPrimitive().type;
+        if (v.isInt() && base == PrimitiveType::Integer)
+            return make_node<Literal>(std::to_string(v.asInt()), type);
+        if (v.isBool() && base == PrimitiveType::Boolean)
+            return make_node<Literal>(v.asBool() ? "True" : "False", type);
+        if (v.isRat() && base == PrimitiveType::Float && std::isfinite(v.asRat())) {
+            ///round trips the double and stays a floating literal in C
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.17g", v.asRat());
+            string text = buffer;
+            if (text.find_first_of(".e") == string::npos)
+                text += ".0";
+            return make_node<Literal>(text, type);
+        }
+        return nullptr;
+    }
+
+    any ConstantFolder::visit(FunctionCall* fcall)
+    {
+        for (auto& e : fcall->arguments)
+            e = fold(e);
+        if (!fcall->fnode || !isPure(fcall->fnode))
+            return (Expression*) fcall;
+
+        ///strings would need the heap of the vm to outlive the call
+        vector<Value> args;
+        for (auto& e : fcall->arguments) {
+            if (e->exprtype != ExprType::LITERAL)
+                return (Expression*) fcall;
+            auto literal = static_cast<Literal*>(e);
+            if (!literal->type.isPrimitive() || literal->type.asPrimitive().type == PrimitiveType::Char)
+                return (Expression*) fcall;
+            args.push_back(ConstantPool::decode(literal));
+        }
+
+        try {
+            Literal* result = toLiteral(vm.call(fcall->fnode, args), fcall->getType());
+            if (!result)
+                return (Expression*) fcall;
+            result->lineIndex = static_cast<Expression*>(fcall)->lineIndex;
+            return (Expression*) result;
+        } catch (RuntimeError&) {
+            return (Expression*) fcall;
+        }
+    }
+
+    any ConstantFolder::visit(Literal* literal)
+    {
+        return (Expression*) literal;
+    }
+
+    any ConstantFolder::visit(BinaryOperation* bop)
+    {
+        bop->lhs = fold(bop->lhs);
+        bop->rhs = fold(bop->rhs);
+        return (Expression*) bop;
+    }
+
+    any ConstantFolder::visit(Variable* var)
+    {
+        if (var->isField())
+            var->asField()->base = fold(var->asField()->base);
+        return (Expression*) var;
+    }
+
+    any ConstantFolder::visit(DynamicAllocation* alloc)
+    {
+        alloc->sizeExpr = fold(alloc->sizeExpr);
+        return (Expression*) alloc;
+    }
+
+    any ConstantFolder::visit(ArrayExpression* arr)
+    {
+        return (Expression*) arr;
+    }
+
+    any ConstantFolder::visit(ArrayIndex* ind)
+    {
+        ind->baseArray = fold(ind->baseArray);
+        ind->index = fold(ind->index);
+        return (Expression*) ind;
+    }
+
+    any ConstantFolder::visit(TakeReference* ref)
+    {
+        ref->baseExpr = fold(ref->baseExpr);
+        return (Expression*) ref;
+    }
+
+    any ConstantFolder::visit(Cast* cast)
+    {
+        cast->expr = fold(cast->expr);
+        return (Expression*) cast;
+    }
+
+    void ConstantFolder::visit(Assigment* assig)
+    {
+        assig->expr = fold(assig->expr);
+        if (assig->variable->isField())
+            assig->variable->asField()->base = fold(assig->variable->asField()->base);
+    }
+
+    void ConstantFolder::visit(If_Else* if_else)
+    {
+        if_else->condition = fold(if_else->condition);
+        foldStatement(if_else->ifBlock);
+        foldStatement(if_else->elseBlock);
+    }
+
+    void ConstantFolder::visit(While* while_loop)
+    {
+        while_loop->condition = fold(while_loop->condition);
+        foldStatement(while_loop->block);
+    }
+
+    void ConstantFolder::visit(Return* ret)
+    {
+        ret->expr = fold(ret->expr);
+    }
+
+    void ConstantFolder::visit(StatementBlock* block)
+    {
+        for (auto& e : block->block)
+            foldStatement(e);
+    }
+
+    void ConstantFolder::visit(For* f) {}
+}
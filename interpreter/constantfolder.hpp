@@ -0,0 +1,38 @@
+#pragma once
+#include "interpreter/vm.hpp"
+#include "ast/treevisitor.hpp"
+#include "common/module.hpp"
+
+namespace kvantum::interpreter
+{
+    /*
+        evaluates calls of pure => functions whose arguments are all literals on the vm
+        and puts the literal of the result in place of the call, so code generation
+        sees a constant, calls that fail at runtime are kept and fail when the program runs
+    */
+    class ConstantFolder : public TreeVisitor
+    {
+    IMPLEMENTS_TREE_VISITOR
+    public:
+        ///a pure function that recurses deeper is left to run at runtime
+        static constexpr size_t MAX_CALL_DEPTH = 10000;
+
+        ConstantFolder();
+        ///folds the calls in every function of a type checked module
+        void fold(Module* mod);
+
+    private:
+        ///the expression to use in place of expr
+        Expression* fold(Expression* expr);
+        void foldStatement(Statement* st);
+        ///a => function over its parameters, literals and other pure functions
+        bool isPure(FunctionNode* f);
+        bool isPure(Expression* expr);
+        ///nullptr if the value has no literal of the type
+        static Literal* toLiteral(const Value& v, Type& type);
+
+        VirtualMachine vm;
+        VirtualFunctionInterpreter builtins;
+        std::unordered_map<FunctionNode*, bool> purity;
+    };
+}
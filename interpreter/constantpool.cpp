@@ -0,0 +1,155 @@
+#include "interpreter/constantpool.hpp"
+
+namespace kvantum::interpreter
+{
+    Value ConstantPool::decode(Literal* literal)
+    {
+        if (!literal->type.isPrimitive())
+            return Value(newString(literal->value));
+        switch (literal->type.asPrimitive().type) {
+        case PrimitiveType::Integer:
+            return Value((int64_t) std::stoll(literal->value));
+        case PrimitiveType::Float:
+            return Value(std::stod(literal->value));
+        case PrimitiveType::Char:
+            return Value(newString(literal->value));
+        case PrimitiveType::Boolean:
+            return Value(literal->value == "True");
+        default:
+            return Value();
+        }
+    }
+
+    void ConstantPool::load(FunctionNode* f)
+    {
+        pending.push_back(f);
+        while (!pending.empty()) {
+            FunctionNode* next = pending.back();
+            pending.pop_back();
+            visit_function(next);
+        }
+    }
+
+    static std::atomic<uint32_t> nextConstant = 0;
+
+    const Value& ConstantPool::add(Literal* literal)
+    {
+        if (literal->constant == UINT32_MAX)
+            literal->constant = nextConstant++;
+        if (values.size() <= literal->constant)
+            values.resize(literal->constant + 1);
+        values[literal->constant] = decode(literal);
+        return *values[literal->constant];
+    }
+
+    void ConstantPool::mark(Heap& heap) const
+    {
+        for (auto& e : values)
+            if (e)
+                heap.mark(*e);
+    }
+
+    void ConstantPool::visit_function(FunctionNode* f)
+    {
+        if (!f || !loaded.insert(f).second)
+            return;
+        for (auto& e : f->ast)
+            visit_statement(e);
+    }
+
+    any ConstantPool::visit(Literal* literal)
+    {
+        get(literal);
+        return {};
+    }
+
+    any ConstantPool::visit(BinaryOperation* bop)
+    {
+        visit_expression(bop->lhs);
+        visit_expression(bop->rhs);
+        return {};
+    }
+
+    any ConstantPool::visit(Variable* var)
+    {
+        if (var->isField())
+            visit_expression(var->asField()->base);
+        return {};
+    }
+
+    any ConstantPool::visit(DynamicAllocation* alloc)
+    {
+        visit_expression(alloc->sizeExpr);
+        return {};
+    }
+
+    any ConstantPool::visit(ArrayExpression* arr)
+    {
+        for (auto& e : arr->initializer)
+            visit_expression(e);
+        return {};
+    }
+
+    any ConstantPool::visit(ArrayIndex* ind)
+    {
+        visit_expression(ind->baseArray);
+        visit_expression(ind->index);
+        return {};
+    }
+
+    any ConstantPool::visit(FunctionCall* fcall)
+    {
+        for (auto& e : fcall->arguments)
+            visit_expression(e);
+        if (fcall->fnode && !loaded.count(fcall->fnode))
+            pending.push_back(fcall->fnode);
+        return {};
+    }
+
+    any ConstantPool::visit(TakeReference* ref)
+    {
+        visit_expression(ref->baseExpr);
+        return {};
+    }
+
+    any ConstantPool::visit(Cast* cast)
+    {
+        visit_expression(cast->expr);
+        return {};
+    }
+
+    void ConstantPool::visit(Assigment* assig)
+    {
+        if (assig->variable->isField())
+            visit_expression(assig->variable->asField()->base);
+        visit_expression(assig->expr);
+    }
+
+    void ConstantPool::visit(If_Else* if_else)
+    {
+        visit_expression(if_else->condition);
+        visit_statement(if_else->ifBlock);
+        if (if_else->elseBlock)
+            visit_statement(if_else->elseBlock);
+    }
+
+    void ConstantPool::visit(While* while_loop)
+    {
+        visit_expression(while_loop->condition);
+        visit_statement(while_loop->block);
+    }
+
+    void ConstantPool::visit(Return* ret)
+    {
+        if (ret->expr)
+            visit_expression(ret->expr);
+    }
+
+    void ConstantPool::visit(StatementBlock* block)
+    {
+        for (auto& e : block->block)
+            visit_statement(e);
+    }
+
+    void ConstantPool::visit(For* f) {}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "interpreter/heap.hpp"
+#include "ast/treevisitor.hpp"
+#include "ast/functionnode.hpp"
+#include <unordered_set>
+#include <atomic>
+#include <optional>
+
+namespace kvantum::interpreter
+{
+    /*
+        every literal decoded once into a typed value, keyed by the index the node carries,
+        the engines load the functions they run before running them
+    */
+    class ConstantPool : public TreeVisitor
+    {
+    IMPLEMENTS_TREE_VISITOR
+    public:
+        ///decodes the literals of the function and of every function it calls
+        void load(FunctionNode* f);
+        ///literals created after loading, by folding for example, are decoded on the first lookup
+        const Value& get(Literal* literal)
+        {
+            if (literal->constant < values.size() && values[literal->constant])
+                return *values[literal->constant];
+            return add(literal);
+        }
+        void mark(Heap& heap) const;
+
+        ///strings are allocated in the active heap
+        static Value decode(Literal* literal);
+
+    private:
+        void visit_function(FunctionNode* f);
+        const Value& add(Literal* literal);
+
+        ///indexed by Literal::constant, the indices are shared by all pools
+        vector<std::optional<Value>> values;
+        std::unordered_set<FunctionNode*> loaded;
+        ///called functions which are not walked yet, a worklist keeps deep call chains off the stack
+        vector<FunctionNode*> pending;
+    };
+}
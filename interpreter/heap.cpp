@@ -0,0 +1,192 @@
+#include "interpreter/heap.hpp"
+#include <mutex>
+
+namespace kvantum::interpreter
+{
+    static std::mutex layoutsMutex;
+    static std::unordered_map<ObjectType*, unique_ptr<ObjectLayout>> layouts;
+
+    static Value defaultValue(Type& type)
+    {
+        if (!type.isPrimitive())
+            return Value();
+        switch (type.asPrimitive().type) {
+        case PrimitiveType::Integer:
+            return Value(0);
+        case PrimitiveType::Float:
+            return Value(0.0);
+        case PrimitiveType::Boolean:
+            return Value(false);
+        default:
+            return Value();
+        }
+    }
+
+    const ObjectLayout& ObjectLayout::of(ObjectType& type)
+    {
+        std::lock_guard<std::mutex> lock(layoutsMutex);
+        auto& layout = layouts[&type];
+        if (!layout) {
+            layout = std::make_unique<ObjectLayout>();
+            layout->type = &type;
+            for (auto& [name, fieldType] : type.getFields()) {
+                layout->slots.emplace(SymbolTable::intern(name), layout->defaults.size());
+                layout->defaults.push_back(defaultValue(*fieldType));
+            }
+        }
+        return *layout;
+    }
+
+    uint16_t ObjectLayout::slotOf(SymbolID field) const
+    {
+        auto iter = slots.find(field);
+        if (iter == slots.end())
+            throw std::invalid_argument(type->getName() + " has no field named " + SymbolTable::getName(field));
+        return iter->second;
+    }
+
+    ObjectValue::ObjectValue(const ObjectLayout& layout)
+        : HeapCell(OBJECT)
+        , layout(layout)
+        , fields(layout.defaults)
+    {
+    }
+
+    StrValue* newString(string value)
+    {
+        return Heap::current().allocateString(std::move(value));
+    }
+
+    ///approximate number of bytes owned by the cell, only used to pace the collections
+    static size_t cellSize(HeapCell* cell)
+    {
+        switch (cell->kind) {
+        case HeapCell::STR:
+            return sizeof(StrValue) + static_cast<StrValue*>(cell)->value.capacity();
+        case HeapCell::ARRAY:
+            return sizeof(ArrayValue) + static_cast<ArrayValue*>(cell)->values.capacity() * sizeof(Value);
+        case HeapCell::OBJECT:
+            return sizeof(ObjectValue) + static_cast<ObjectValue*>(cell)->fields.capacity() * sizeof(Value);
+        }
+        return 0;
+    }
+
+    static void destroy(HeapCell* cell)
+    {
+        switch (cell->kind) {
+        case HeapCell::STR:
+            delete static_cast<StrValue*>(cell);
+            break;
+        case HeapCell::ARRAY:
+            delete static_cast<ArrayValue*>(cell);
+            break;
+        case HeapCell::OBJECT:
+            delete static_cast<ObjectValue*>(cell);
+            break;
+        }
+    }
+
+    Heap::~Heap()
+    {
+        while (cells) {
+            HeapCell* next = cells->next;
+            destroy(cells);
+            cells = next;
+        }
+    }
+
+    Heap& Heap::current()
+    {
+        static thread_local Heap fallback;
+        return active ? *active : fallback;
+    }
+
+    StrValue* Heap::allocateString(string value)
+    {
+        auto cell = new StrValue(std::move(value));
+        track(cell, cellSize(cell));
+        return cell;
+    }
+
+    ArrayValue* Heap::allocateArray(vector<Value> values)
+    {
+        auto cell = new ArrayValue(std::move(values));
+        track(cell, cellSize(cell));
+        return cell;
+    }
+
+    ObjectValue* Heap::allocateObject(const ObjectLayout& layout)
+    {
+        auto cell = new ObjectValue(layout);
+        track(cell, cellSize(cell));
+        return cell;
+    }
+
+    void Heap::track(HeapCell* cell, size_t size)
+    {
+        cell->next = cells;
+        cells = cell;
+        cellCount++;
+        allocatedBytes += size;
+    }
+
+    void Heap::mark(const Value& value)
+    {
+        HeapCell* cell;
+        switch (value.tag) {
+        case Value::STR:
+            cell = value.asStr();
+            break;
+        case Value::ARRAY:
+            cell = value.asArray();
+            break;
+        case Value::OBJECT:
+            cell = value.asObj();
+            break;
+        default:
+            return;
+        }
+        if (cell->marked)
+            return;
+        cell->marked = true;
+        if (cell->kind != HeapCell::STR)
+            grey.push_back(cell);
+    }
+
+    void Heap::collect(const std::function<void(Heap&)>& markRoots)
+    {
+        markRoots(*this);
+        while (!grey.empty()) {
+            HeapCell* cell = grey.back();
+            grey.pop_back();
+            auto& children = cell->kind == HeapCell::ARRAY ? static_cast<ArrayValue*>(cell)->values
+                                                           : static_cast<ObjectValue*>(cell)->fields;
+            for (auto& e : children)
+                mark(e);
+        }
+        sweep();
+        ///the next collection comes after allocating as much again as survived this one
+        allocatedBytes = 0;
+        threshold = std::max(MIN_THRESHOLD, liveBytes);
+    }
+
+    void Heap::sweep()
+    {
+        liveBytes = 0;
+        HeapCell** link = &cells;
+        while (*link) {
+            HeapCell* cell = *link;
+            if (cell->marked) {
+                cell->marked = false;
+                liveBytes += cellSize(cell);
+                link = &cell->next;
+            } else {
+                *link = cell->next;
+                destroy(cell);
+                cellCount--;
+            }
+        }
+    }
+
+    thread_local Heap* Heap::active = nullptr;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "interpreter/value.hpp"
+#include <unordered_map>
+
+namespace kvantum::interpreter
+{
+    /*
+        field slots of an object type, the parent fields come first
+        in the order of ObjectType::getFields
+    */
+    struct ObjectLayout
+    {
+        ///layouts are built once per type and shared by every heap
+        static const ObjectLayout& of(ObjectType& type);
+
+        uint16_t slotOf(SymbolID field) const;
+
+        ObjectType* type;
+        ///initial value of every slot, zero for the primitive fields
+        vector<Value> defaults;
+        std::unordered_map<SymbolID, uint16_t> slots;
+    };
+
+    /*
+        owner of the strings, arrays and objects of a running program,
+        a precise mark and sweep collector which asks the engine for its roots
+    */
+    class Heap
+    {
+    public:
+        Heap() = default;
+        Heap(const Heap&) = delete;
+        ~Heap();
+
+        /*
+            makes the heap the target of the allocations on this thread until the activation goes out of scope
+        */
+        class Activation
+        {
+        public:
+            explicit Activation(Heap& heap)
+                : previous(active)
+            {
+                active = &heap;
+            }
+            ~Activation() { active = previous; }
+
+        private:
+            Heap* previous;
+        };
+
+        /// the heap activated on this thread or the thread's own fallback heap
+        static Heap& current();
+
+        StrValue* allocateString(string value);
+        ArrayValue* allocateArray(vector<Value> values);
+        ObjectValue* allocateObject(const ObjectLayout& layout);
+
+        ///true once the allocations since the last collection passed the threshold
+        bool shouldCollect() const { return allocatedBytes >= threshold; }
+        ///markRoots marks every value the engine can still reach, everything else is freed
+        void collect(const std::function<void(Heap&)>& markRoots);
+        void mark(const Value& value);
+        size_t getCellCount() const { return cellCount; }
+
+    private:
+        void track(HeapCell* cell, size_t size);
+        void sweep();
+
+        static constexpr size_t MIN_THRESHOLD = 1 << 20;
+
+        HeapCell* cells = nullptr;
+        ///cells reached but not scanned yet, an explicit stack so deep structures cannot overflow
+        vector<HeapCell*> grey;
+        size_t cellCount = 0;
+        size_t allocatedBytes = 0;
+        size_t liveBytes = 0;
+        size_t threshold = MIN_THRESHOLD;
+
+        static thread_local Heap* active;
+    };
+}
@@ -0,0 +1,21 @@
+#include "interpreter/inlinecache.hpp"
+
+namespace kvantum::interpreter
+{
+    bool isVirtualCall(FunctionNode* f)
+    {
+        return f->isMethod() && !f->hasTrait(FunctionNode::STATIC)
+               && (f->hasTrait(FunctionNode::VIRTUAL) || f->hasTrait(FunctionNode::OVERRIDE));
+    }
+
+    FunctionNode* resolveOverride(FunctionNode* method, ObjectType& receiver)
+    {
+        for (ObjectType* t = &receiver; t; t = t->getParent()) {
+            auto& methods = t->getNode()->methods;
+            auto iter = methods.find(method->getName());
+            if (iter != methods.end())
+                return iter->second;
+        }
+        return method;
+    }
+}
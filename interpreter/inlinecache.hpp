@@ -0,0 +1,47 @@
+#pragma once
+#include "ast/functionnode.hpp"
+#include <array>
+
+namespace kvantum::interpreter
+{
+    ///true if the method has to be looked up on the type of the receiver
+    bool isVirtualCall(FunctionNode* f);
+    ///the override of the method closest to the receiver type, walking up the parents
+    FunctionNode* resolveOverride(FunctionNode* method, ObjectType& receiver);
+
+    /*
+        receiver types seen by a virtual call site and what they dispatched to,
+        monomorphic while a single type was seen and polymorphic up to LIMIT types,
+        a megamorphic site keeps its first entries and resolves the other types on every call
+    */
+    template<typename Target>
+    class InlineCache
+    {
+    public:
+        static constexpr unsigned int LIMIT = 4;
+
+        ///resolve is only called on a miss
+        template<typename Resolve>
+        Target lookup(ObjectType* receiver, Resolve&& resolve)
+        {
+            for (unsigned int i = 0; i < count; i++) {
+                if (entries[i].receiver == receiver)
+                    return entries[i].target;
+            }
+            Target target = resolve(*receiver);
+            if (count < LIMIT)
+                entries[count++] = {receiver, target};
+            return target;
+        }
+
+    private:
+        struct Entry
+        {
+            ObjectType* receiver;
+            Target target;
+        };
+
+        std::array<Entry, LIMIT> entries;
+        unsigned int count = 0;
+    };
+}
@@ -1,33 +1,14 @@
 #include "interpreter/interpreter.hpp"
+#include "interpreter/slotresolver.hpp"
+#include <atomic>
 
 namespace kvantum::interpreter
 {
-    Value* VirtualFunctionInterpreter::interpret(string funcname, vector<Value*> args)
-    {
-        if (!functions.count(funcname))
-            throw std::invalid_argument("no function named " + funcname);
-        return functions.at(funcname)(args);
-    }
-
-    Value* VirtualFunctionInterpreter::printf(vector<Value*> args)
-    {
-        std::cout << args[0]->asStr()->value;
-        return (Value*) new VoidValue();
-    }
-
-    Value* VirtualFunctionInterpreter::malloc(vector<Value*> args)
-    {
-        return (Value*) new VoidValue();
-    }
-
-    Value* VirtualFunctionInterpreter::memcpy(vector<Value*> args)
-    {
-        return (Value*) new VoidValue();
-    }
-
     void Interpreter::generate(Module* mod)
     {
         this->mod = mod;
+        Heap::Activation activation(heap);
+        constants.load(mod->getMainFunction());
     }
 
     void Interpreter::generateFunction(FunctionNode* f) {}
@@ -36,164 +17,320 @@ namespace kvantum::interpreter
 
     void Interpreter::exec()
     {
-        interpretFunction(mod->getMainFunction(), {});
+        Heap::Activation activation(heap);
+        ///frames left behind by an error of the previous exec
+        stack.clear();
+        operands.clear();
+        frameBase = 0;
+        tailCall = nullptr;
+        char bottom;
+        stackBase = (uintptr_t) &bottom;
+        try {
+            result = interpretFunction(mod->getMainFunction(), nullptr);
+        } catch (std::invalid_argument& e) {
+            if (profiler)
+                profiler->unwind();
+            throw RuntimeError(e.what());
+        }
     }
 
-    Value* Interpreter::interpretFunction(FunctionNode* node, vector<Value*> args)
+    Value Interpreter::interpretFunction(FunctionNode* node, const Value* args)
     {
-        vector<pair<string, Value*>> values;
-        values.resize(args.size());
-        for (int i = 0; i < args.size(); i++) {
-            values[i] = pair(node->formalParams[i]->id, args[i]);
-        }
-        symbols.pushSegment(values);
+        ///calls recurse on the host stack, which grows down
+        char marker;
+        if (stackBase - (uintptr_t) &marker > STACK_BUDGET)
+            throw std::invalid_argument("call stack overflow calling " + node->getName());
+        if (profiler)
+            profiler->enter(node);
+        size_t callerBase = frameBase;
+        frameBase = stack.size();
+        enterFrame(node, args);
 
-        int i = 0;
-        returnVal = nullptr;
-        while (i < node->ast.size() && returnVal == nullptr) {
-            visit_statement(node->ast[i++]);
+        for (;;) {
+            int i = 0;
+            returnVal.reset();
+            while (i < node->ast.size() && !returnVal) {
+                interpretStatement(node->ast[i++]);
+            }
+            if (!tailCall)
+                break;
+            ///the tail call reuses the frame, so tail recursion runs in constant host stack
+            node = std::exchange(tailCall, nullptr);
+            if (profiler) {
+                profiler->leave();
+                profiler->enter(node);
+            }
+            stack.resize(frameBase);
+            enterFrame(node, operands.data() + tailArgs);
+            operands.resize(tailArgs);
         }
-        symbols.popSegment();
-        return (Value*) returnVal ? returnVal : new VoidValue();
+        stack.resize(frameBase);
+        frameBase = callerBase;
+        ///the caller is in the middle of a statement, it must not see the return of the callee
+        Value value = returnVal.value_or(Value());
+        returnVal.reset();
+        if (profiler)
+            profiler->leave();
+        return value;
+    }
+
+    void Interpreter::enterFrame(FunctionNode* node, const Value* args)
+    {
+        SlotResolver::resolve(node);
+        stack.resize(frameBase + *node->frameSize);
+        std::copy(args, args + node->formalParams.size(), stack.begin() + frameBase);
     }
 
     any Interpreter::visit(Literal* literal)
     {
-        PrimitiveType &t = literal->type.asPrimitive();
-        Value* value = new VoidValue();
-        switch (t.type) {
-            case PrimitiveType::Integer:
-                value = new IntValue(std::stoi(literal->value));
-                break;
-            case PrimitiveType::Float:
-                value = new RatValue(std::stod(literal->value));
-                break;
-            case PrimitiveType::Char:
-                value = new StrValue(literal->value);
-                break;
-            case PrimitiveType::Boolean:
-                value = new BoolValue(literal->value == "True");
-                break;
-        }
-        return (Value*) value;
+        evaluated = constants.get(literal);
+        return {};
     }
 
     any Interpreter::visit(BinaryOperation* bop)
     {
-        Value* l = eval(bop->lhs);
-        Value* r = eval(bop->rhs);
-        Value* value = new VoidValue();
+        Value l = eval(bop->lhs);
+        operands.push_back(l);
+        Value r = eval(bop->rhs);
+        operands.pop_back();
         switch (bop->op) {
-            CASE(BinaryOperation::ADD, value = l->add(r));
-            CASE(BinaryOperation::SUBTRACT, value = l->sub(r));
-            CASE(BinaryOperation::MULTIPLY, value = l->mul(r));
-            CASE(BinaryOperation::DIVIDE, value = l->div(r));
-            CASE(BinaryOperation::EQUAL, value = l->sub(r));
-            CASE(BinaryOperation::NOT_EQUAL, value = l->sub(r));
-            CASE(BinaryOperation::LESS, value = l->sub(r));
-            CASE(BinaryOperation::LESS_OR_EQUAL, value = l->sub(r));
-            CASE(BinaryOperation::GREATER, value = l->sub(r));
-            CASE(BinaryOperation::GREATER_OR_EQUAL, value = l->sub(r));
-            CASE(BinaryOperation::AND, value = l->sub(r));
-            CASE(BinaryOperation::OR, value = l->sub(r));
+            CASE(BinaryOperation::ADD, evaluated = l.add(r));
+            CASE(BinaryOperation::SUBTRACT, evaluated = l.sub(r));
+            CASE(BinaryOperation::MULTIPLY, evaluated = l.mul(r));
+            CASE(BinaryOperation::DIVIDE, evaluated = l.div(r));
+            CASE(BinaryOperation::EQUAL, evaluated = Value(l.compare(r) == 0));
+            CASE(BinaryOperation::NOT_EQUAL, evaluated = Value(l.compare(r) != 0));
+            CASE(BinaryOperation::LESS, evaluated = Value(l.compare(r) < 0));
+            CASE(BinaryOperation::LESS_OR_EQUAL, evaluated = Value(l.compare(r) <= 0));
+            CASE(BinaryOperation::GREATER, evaluated = Value(l.compare(r) > 0));
+            CASE(BinaryOperation::GREATER_OR_EQUAL, evaluated = Value(l.compare(r) >= 0));
+            CASE(BinaryOperation::AND, evaluated = l.mul(r));
+            CASE(BinaryOperation::OR, evaluated = l.add(r));
+        default:
+            evaluated = Value();
         }
-        return (Value*) value;
+        return {};
     }
 
     any Interpreter::visit(Variable* var)
     {
-        if (!var->isField())
-            return (Value*) symbols.get(var->id);
+        evaluated = var->isField() ? fieldSlot(var->asField()) : local(var);
+        return {};
     }
 
     any Interpreter::visit(DynamicAllocation* alloc)
     {
-        Value* arg = eval(alloc->sizeExpr);
-        return builtinInterpreter.interpret("malloc", {arg});
+        if (alloc->node.isObject()) {
+            evaluated = Value(heap.allocateObject(ObjectLayout::of(alloc->node.asObject())));
+            return {};
+        }
+        Value arg = eval(alloc->sizeExpr);
+        evaluated = builtinInterpreter.call(VirtualFunctionInterpreter::MALLOC, &arg, 1);
+        return {};
     }
 
     any Interpreter::visit(ArrayExpression* arr)
     {
-        vector<Value*>* values = new vector<Value*>();
+        size_t base = operands.size();
         for (auto &e: arr->initializer) {
-            values->push_back(eval(e));
+            operands.push_back(eval(e));
         }
-        return (Value*) new ArrayValue(values);
+        evaluated = Value(heap.allocateArray(vector<Value>(operands.begin() + base, operands.end())));
+        operands.resize(base);
+        return {};
     }
 
     any Interpreter::visit(FunctionCall* fcall)
     {
-        auto evalArgs = [this](vector<Expression*> arguments) {
-            return apply(ITER_THROUGH(arguments), std::function([this](Expression* e) {
-                return eval(e);
-            }));
-        };
-
-        if (builtinInterpreter.isValidFunction(fcall->fnode->getName())) {
-            return builtinInterpreter.interpret(fcall->fnode->getName(), evalArgs(fcall->arguments));
+        CallSite& site = callSite(fcall);
+        size_t base = operands.size();
+        for (auto &e : fcall->arguments) {
+            operands.push_back(eval(e));
         }
-        return interpretFunction(fcall->fnode, evalArgs(fcall->arguments));
+
+        if (site.builtin != VirtualFunctionInterpreter::NONE) {
+            if (profiler)
+                profiler->enter(fcall->fnode);
+            evaluated = builtinInterpreter.call(site.builtin, operands.data() + base, operands.size() - base);
+            if (profiler)
+                profiler->leave();
+        } else
+            evaluated = interpretFunction(resolveCall(site, operands.data() + base), operands.data() + base);
+        operands.resize(base);
+        return {};
     }
 
     any Interpreter::visit(ArrayIndex* ind)
     {
-        auto base = eval(ind->baseArray);
-        auto index = eval(ind->index);
-        return base->asArray()->index(index->asInt()->value);
+        Value base = eval(ind->baseArray);
+        operands.push_back(base);
+        Value index = eval(ind->index);
+        operands.pop_back();
+        evaluated = base.asArray()->index(index.asInt());
+        return {};
     }
 
     any Interpreter::visit(TakeReference* ref)
     {
-        return eval(ref->baseExpr);
+        eval(ref->baseExpr);
+        return {};
     }
 
     any Interpreter::visit(Cast* cast)
     {
-        auto val = eval(cast->expr);
-        return new VoidValue();
+        eval(cast->expr);
+        evaluated = Value();
+        return {};
     }
 
     void Interpreter::visit(Assigment* assig)
     {
-        if (assig->isDeclaration())
-            symbols.push({assig->variable->id, eval(assig->expr)});
-        symbols.getNode(assig->variable->id).second = eval(assig->expr);
+        if (assig->variable->isField()) {
+            Value value = eval(assig->expr);
+            operands.push_back(value);
+            fieldSlot(assig->variable->asField()) = value;
+            operands.pop_back();
+            return;
+        }
+        ///a declaration only differs by its slot, which the resolver already picked
+        Value value = eval(assig->expr);
+        local(assig->variable) = value;
     }
 
     void Interpreter::visit(If_Else* if_else)
     {
-        if (eval(if_else->condition)->asBool()->value)
-            visit_statement(if_else->ifBlock);
+        if (eval(if_else->condition).asBool())
+            interpretStatement(if_else->ifBlock);
         else if (if_else->elseBlock)
-            visit_statement(if_else->elseBlock);
+            interpretStatement(if_else->elseBlock);
     }
 
     void Interpreter::visit(While* while_loop)
     {
-        while (returnVal == nullptr && eval(while_loop->condition)) {
-            visit_statement(while_loop->block);
+        while (!returnVal && eval(while_loop->condition).asBool()) {
+            interpretStatement(while_loop->block);
         }
     }
 
     void Interpreter::visit(Return* ret)
     {
+        if (ret->expr && ret->expr->exprtype == ExprType::FUNCTION_CALL) {
+            auto fcall = static_cast<FunctionCall*>(ret->expr);
+            CallSite& site = callSite(fcall);
+            if (site.builtin == VirtualFunctionInterpreter::NONE) {
+                tailArgs = operands.size();
+                for (auto& e : fcall->arguments)
+                    operands.push_back(eval(e));
+                tailCall = resolveCall(site, operands.data() + tailArgs);
+                ///the frame is done, interpretFunction makes the call
+                returnVal = Value();
+                return;
+            }
+        }
         returnVal = eval(ret->expr);
     }
 
     void Interpreter::visit(StatementBlock* block)
     {
-        symbols.pushSegment({});
         int i = 0;
-        while (i < block->block.size() && returnVal == nullptr) {
-            visit_statement(block->block[i++]);
+        while (i < block->block.size() && !returnVal) {
+            interpretStatement(block->block[i++]);
         }
-        symbols.popSegment();
     }
     void Interpreter::visit(For* f) {}
 
 
-    Value* Interpreter::eval(Expression* expr)
+    Value Interpreter::eval(Expression* expr)
+    {
+        visit_expression(expr);
+        return evaluated;
+    }
+
+    void Interpreter::interpretStatement(Statement* st)
+    {
+        safePoint();
+        if (profiler)
+            profiler->statement(st);
+        visit_statement(st);
+    }
+
+    Value& Interpreter::local(Variable* var)
+    {
+        if (var->slot == Variable::NO_SLOT)
+            throw std::invalid_argument("unresolved variable " + var->id);
+        return stack[frameBase + var->slot];
+    }
+
+    static std::atomic<uint32_t> nextCallSite = 0;
+
+    CallSite& Interpreter::callSite(FunctionCall* fcall)
+    {
+        if (fcall->callSite < callSites.size() && callSites[fcall->callSite])
+            return *callSites[fcall->callSite];
+        if (fcall->callSite == UINT32_MAX)
+            fcall->callSite = nextCallSite++;
+        if (callSites.size() <= fcall->callSite)
+            callSites.resize(fcall->callSite + 1);
+
+        ///the name lookups happen once per call site
+        auto builtin = builtinInterpreter.find(fcall->fnode);
+        if (builtin != VirtualFunctionInterpreter::NONE
+            && !builtinInterpreter.get(builtin).accepts(fcall->arguments.size()))
+            throw std::invalid_argument("wrong number of arguments for " + fcall->fnode->getName());
+        callSites[fcall->callSite] = std::make_unique<CallSite>();
+        CallSite& site = *callSites[fcall->callSite];
+        site.builtin = builtin;
+        site.target = fcall->fnode;
+        site.isVirtual = isVirtualCall(fcall->fnode);
+        return site;
+    }
+
+    FunctionNode* Interpreter::resolveCall(CallSite& site, const Value* args)
+    {
+        if (!site.isVirtual)
+            return site.target;
+        if (!args[0].isObj())
+            throw std::invalid_argument("cannot call " + site.target->getName() + " on a non-object");
+        return site.receivers.lookup(args[0].asObj()->layout.type, [&site](ObjectType& receiver) {
+            return resolveOverride(site.target, receiver);
+        });
+    }
+
+    Value& Interpreter::fieldSlot(FieldAccess* access)
+    {
+        auto slot = [](const Value& object, SymbolID field) -> Value& {
+            if (!object.isObj())
+                throw std::invalid_argument("cannot access field " + SymbolTable::getName(field)
+                                            + " of a non-object");
+            ObjectValue* obj = object.asObj();
+            return obj->fields[obj->layout.slotOf(field)];
+        };
+
+        ///a.b.c nests to the right, the base is evaluated once and the field chain is walked
+        Value object = eval(access->base);
+        Variable* field = access->field;
+        while (field->isField()) {
+            FieldAccess* inner = field->asField();
+            object = slot(object, inner->base->as<Variable*>()->symbol);
+            field = inner->field;
+        }
+        return slot(object, field->symbol);
+    }
+
+    void Interpreter::safePoint()
     {
-        return any_cast<Value*>(visit_expression(expr));
+        if (!heap.shouldCollect())
+            return;
+        heap.collect([this](Heap& heap) {
+            for (auto& e : stack)
+                heap.mark(e);
+            for (auto& e : operands)
+                heap.mark(e);
+            heap.mark(evaluated);
+            heap.mark(result);
+            constants.mark(heap);
+            if (returnVal)
+                heap.mark(*returnVal);
+        });
     }
 }
\ No newline at end of file
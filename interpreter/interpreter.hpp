@@ -1,31 +1,31 @@
 #pragma once
-#include "value.hpp"
+#include "interpreter/builtins.hpp"
+#include "interpreter/constantpool.hpp"
+#include "interpreter/inlinecache.hpp"
+#include "interpreter/profiler.hpp"
 #include "ast/ast.hpp"
 #include "ast/treevisitor.hpp"
 #include "codegen/codeexecutorinterface.hpp"
-#include "parser/symbolstack.hpp"
+#include <optional>
+#include <stdexcept>
 
 namespace kvantum::interpreter
 {
-    class VirtualFunctionInterpreter 
+    ///error raised by a running program, the message names the function and, for the vm, the line
+    struct RuntimeError : public std::runtime_error
     {
-    public:
-        Value* interpret(string funcname,vector<Value*> args);
-        bool isValidFunction(string name) { return functions.count(name); }
-    private:
-        static Value* printf(vector<Value*> args);
-        static Value* malloc(vector<Value*> args);
-        static Value* memcpy(vector<Value*> args);
-
-        const map<string, std::function<Value* (vector<Value*>)>> functions = 
-        { 
-            {"printf",printf},
-            {"malloc",malloc},
-            {"memcpy",memcpy}
-        };
+        using std::runtime_error::runtime_error;
     };
 
-   using kvantum::parser::SymbolStack;
+   ///what a call site resolved to on its first call
+   struct CallSite
+   {
+      VirtualFunctionInterpreter::ID builtin = VirtualFunctionInterpreter::NONE;
+      FunctionNode* target = nullptr;
+      bool isVirtual = false;
+      InlineCache<FunctionNode*> receivers;
+   };
+
    class Interpreter : public TreeVisitor,public codegen::CodeExecutorInterface
    {
    IMPLEMENTS_TREE_VISITOR
@@ -35,13 +35,46 @@ namespace kvantum::interpreter
       void prototypeFunction(FunctionNode* f) override;
       void generateObject(ObjectType* t) override;
       void exec() override;
+      ///value returned by the main function of the last exec
+      Value getResult() const { return result; }
+      ///the profiler records the following execs, nullptr turns it off again
+      void setProfiler(Profiler* p) { profiler = p; }
+      ///host stack the calls may take before the recursion is reported as too deep, most of the usual 8MB
+      static constexpr size_t STACK_BUDGET = 6 << 20;
    private:
-      Value* eval(Expression* expr);
-      Value* interpretFunction(FunctionNode* func,vector<Value*> args);
+      ///expressions leave their value in evaluated, a Value does not fit in the small buffer of any
+      Value eval(Expression* expr);
+      ///the arguments are copied into the new frame before anything else runs
+      Value interpretFunction(FunctionNode* func,const Value* args);
+      void enterFrame(FunctionNode* func,const Value* args);
+      void interpretStatement(Statement* st);
+      Value& local(Variable* var);
+      CallSite& callSite(FunctionCall* fcall);
+      ///the function the site calls with these arguments, the override for virtual calls
+      FunctionNode* resolveCall(CallSite& site,const Value* args);
+      Value& fieldSlot(FieldAccess* field);
+      ///collects the heap if it asks for it, only called between statements
+      void safePoint();
 
       Module* mod;
-      SymbolStack<Value*> symbols;
+      ///frames of the active calls, each one frameSize slots starting at frameBase for the innermost
+      vector<Value> stack;
+      size_t frameBase = 0;
       VirtualFunctionInterpreter builtinInterpreter;
-      Value* returnVal = nullptr;
+      Heap heap;
+      ConstantPool constants;
+      ///indexed by FunctionCall::callSite, nested calls can add sites while one is in use
+      vector<unique_ptr<CallSite>> callSites;
+      ///intermediate values kept alive while the rest of their expression is evaluated
+      vector<Value> operands;
+      Value evaluated;
+      std::optional<Value> returnVal;
+      ///a call in tail position, made once the returning frame is released, its arguments start at tailArgs in operands
+      FunctionNode* tailCall = nullptr;
+      size_t tailArgs = 0;
+      ///address near the bottom of the host stack when exec started
+      uintptr_t stackBase = 0;
+      Value result;
+      Profiler* profiler = nullptr;
    };
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "interpreter/profiler.hpp"
+#include "common/module.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <tuple>
+
+namespace kvantum::interpreter
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    static double millis(Profiler::Clock::duration d)
+    {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    void Profiler::addModule(Module* mod)
+    {
+        for (auto f : mod->getFunctions())
+            moduleOf[f] = mod->getName();
+    }
+
+    string Profiler::nameOf(FunctionNode* f) const
+    {
+        string name = f->isMethod() ? f->getParent().getName() + "." + f->getName() : f->getName();
+        auto iter = moduleOf.find(f);
+        return iter != moduleOf.end() ? iter->second + "::" + name : name;
+    }
+
+    void Profiler::enter(FunctionNode* f)
+    {
+        FunctionStats& stats = functions[f];
+        stats.calls++;
+        stats.active++;
+
+        size_t parent = stack.empty() ? 0 : stack.back().node;
+        auto iter = tree[parent].children.find(f);
+        size_t node;
+        if (iter != tree[parent].children.end())
+            node = iter->second;
+        else {
+            node = tree.size();
+            tree[parent].children.emplace(f, node);
+            tree.push_back({f, parent, {}, {}});
+        }
+        stack.push_back({node, &stats, Clock::now(), {}});
+    }
+
+    void Profiler::leave()
+    {
+        Frame frame = stack.back();
+        stack.pop_back();
+        Clock::duration inclusive = Clock::now() - frame.start;
+        Clock::duration exclusive = inclusive - frame.children;
+
+        FunctionStats& stats = *frame.stats;
+        if (--stats.active == 0)
+            stats.inclusive += inclusive;
+        stats.exclusive += exclusive;
+        tree[frame.node].self += exclusive;
+        if (!stack.empty())
+            stack.back().children += inclusive;
+    }
+
+    void Profiler::unwind()
+    {
+        while (!stack.empty())
+            leave();
+    }
+
+    void Profiler::writeCollapsed(std::ostream& out) const
+    {
+        for (size_t i = 1; i < tree.size(); i++) {
+            auto self = duration_cast<microseconds>(tree[i].self).count();
+            if (self == 0)
+                continue;
+            vector<FunctionNode*> path;
+            for (size_t node = i; node != 0; node = tree[node].parent)
+                path.push_back(tree[node].function);
+            string line = nameOf(path.back());
+            for (auto iter = path.rbegin() + 1; iter != path.rend(); ++iter)
+                line += ";" + nameOf(*iter);
+            out << line << " " << self << "\n";
+        }
+    }
+
+    void Profiler::writeReport(std::ostream& out) const
+    {
+        vector<std::pair<FunctionNode*, const FunctionStats*>> byTime;
+        Clock::duration total{};
+        for (auto& [f, stats] : functions) {
+            byTime.push_back({f, &stats});
+            total += stats.exclusive;
+        }
+        std::sort(ITER_THROUGH(byTime), [](auto& a, auto& b) {
+            return a.second->exclusive > b.second->exclusive;
+        });
+
+        out << std::fixed << std::setprecision(3);
+        out << std::setw(12) << "calls" << std::setw(14) << "incl ms" << std::setw(14) << "excl ms"
+            << std::setw(8) << "excl%" << "  function\n";
+        for (auto& [f, stats] : byTime) {
+            double share = total.count() ? 100.0 * stats->exclusive.count() / total.count() : 0;
+            out << std::setw(12) << stats->calls << std::setw(14) << millis(stats->inclusive)
+                << std::setw(14) << millis(stats->exclusive) << std::setw(7) << std::setprecision(1)
+                << share << "%" << std::setprecision(3) << "  " << nameOf(f) << "\n";
+        }
+
+        ///lines are only reported by count, statements are too short to time one by one
+        const size_t HOT_LINES = 20;
+        vector<std::tuple<uint64_t, FunctionNode*, unsigned int>> lines;
+        for (auto& [f, stats] : functions)
+            for (auto& [line, count] : stats.lines)
+                lines.push_back({count, f, line});
+        std::sort(ITER_THROUGH(lines), [](auto& a, auto& b) { return std::get<0>(a) > std::get<0>(b); });
+        if (lines.size() > HOT_LINES)
+            lines.resize(HOT_LINES);
+
+        out << "\n" << std::setw(12) << "executions" << "  line\n";
+        for (auto& [count, f, line] : lines)
+            out << std::setw(12) << count << "  " << nameOf(f) << ":" << line << "\n";
+    }
+}
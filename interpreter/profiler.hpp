@@ -0,0 +1,76 @@
+#pragma once
+#include "ast/functionnode.hpp"
+#include <chrono>
+#include <ostream>
+#include <unordered_map>
+
+namespace kvantum
+{
+    class Module;
+}
+
+namespace kvantum::interpreter
+{
+    /*
+        counts the calls and statements of an interpreted program and times every call,
+        opt in since reading the clock on every call costs more than most calls
+    */
+    class Profiler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        ///functions are reported as module::name, private functions of two modules can share a name
+        void addModule(Module* mod);
+        void enter(FunctionNode* f);
+        void leave();
+        ///closes the calls left open by a runtime error
+        void unwind();
+        void statement(const Statement* st)
+        {
+            if (!stack.empty())
+                stack.back().stats->lines[st->lineIndex]++;
+        }
+
+        ///one line per distinct call stack with its exclusive time in microseconds, as flamegraph.pl reads it
+        void writeCollapsed(std::ostream& out) const;
+        ///functions by exclusive time followed by the most executed lines
+        void writeReport(std::ostream& out) const;
+
+    private:
+        struct FunctionStats
+        {
+            uint64_t calls = 0;
+            ///recursive calls are only timed by their outermost activation
+            unsigned int active = 0;
+            Clock::duration inclusive{};
+            Clock::duration exclusive{};
+            std::unordered_map<unsigned int, uint64_t> lines;
+        };
+
+        ///a node of the call tree, its path from the root is a collapsed stack
+        struct CallNode
+        {
+            FunctionNode* function;
+            size_t parent;
+            std::unordered_map<FunctionNode*, size_t> children;
+            Clock::duration self{};
+        };
+
+        struct Frame
+        {
+            size_t node;
+            FunctionStats* stats;
+            Clock::time_point start;
+            Clock::duration children{};
+        };
+
+        string nameOf(FunctionNode* f) const;
+
+        std::unordered_map<FunctionNode*, FunctionStats> functions;
+        std::unordered_map<FunctionNode*, string> moduleOf;
+        ///the root has no function
+        vector<CallNode> tree = {{nullptr, 0, {}, {}}};
+        vector<Frame> stack;
+    };
+}
@@ -0,0 +1,132 @@
+#include "interpreter/slotresolver.hpp"
+
+namespace kvantum::interpreter
+{
+    void SlotResolver::resolve(FunctionNode* f)
+    {
+        if (!f->frameSize)
+            SlotResolver(f).resolve();
+    }
+
+    void SlotResolver::resolve()
+    {
+        slots.pushSegment();
+        for (auto& e : function->formalParams)
+            declare(e);
+        for (auto& e : function->ast)
+            visit_statement(e);
+        slots.popSegment();
+        function->frameSize = frameSize;
+    }
+
+    uint16_t SlotResolver::declare(Variable* var)
+    {
+        KVANTUM_VERIFY(used < Variable::NO_SLOT, "too many locals in " + function->getName());
+        var->slot = used++;
+        frameSize = std::max(frameSize, used);
+        slots.push({var->symbol, var->slot});
+        return var->slot;
+    }
+
+    any SlotResolver::visit(Literal* literal)
+    {
+        return {};
+    }
+
+    any SlotResolver::visit(BinaryOperation* bop)
+    {
+        visit_expression(bop->lhs);
+        visit_expression(bop->rhs);
+        return {};
+    }
+
+    any SlotResolver::visit(Variable* var)
+    {
+        if (var->isField())
+            visit_expression(var->asField()->base);
+        else if (slots.isDeclared(var->symbol))
+            var->slot = slots.get(var->symbol);
+        return {};
+    }
+
+    any SlotResolver::visit(DynamicAllocation* alloc)
+    {
+        visit_expression(alloc->sizeExpr);
+        return {};
+    }
+
+    any SlotResolver::visit(ArrayExpression* arr)
+    {
+        for (auto& e : arr->initializer)
+            visit_expression(e);
+        return {};
+    }
+
+    any SlotResolver::visit(ArrayIndex* ind)
+    {
+        visit_expression(ind->baseArray);
+        visit_expression(ind->index);
+        return {};
+    }
+
+    any SlotResolver::visit(FunctionCall* fcall)
+    {
+        for (auto& e : fcall->arguments)
+            visit_expression(e);
+        return {};
+    }
+
+    any SlotResolver::visit(TakeReference* ref)
+    {
+        visit_expression(ref->baseExpr);
+        return {};
+    }
+
+    any SlotResolver::visit(Cast* cast)
+    {
+        visit_expression(cast->expr);
+        return {};
+    }
+
+    void SlotResolver::visit(Assigment* assig)
+    {
+        ///the initializer still sees the variable the declaration shadows
+        visit_expression(assig->expr);
+        if (assig->isDeclaration())
+            declare(assig->variable);
+        else
+            visit_expression(assig->variable);
+    }
+
+    void SlotResolver::visit(If_Else* if_else)
+    {
+        visit_expression(if_else->condition);
+        visit_statement(if_else->ifBlock);
+        if (if_else->elseBlock)
+            visit_statement(if_else->elseBlock);
+    }
+
+    void SlotResolver::visit(While* while_loop)
+    {
+        visit_expression(while_loop->condition);
+        visit_statement(while_loop->block);
+    }
+
+    void SlotResolver::visit(Return* ret)
+    {
+        if (ret->expr)
+            visit_expression(ret->expr);
+    }
+
+    void SlotResolver::visit(StatementBlock* block)
+    {
+        uint16_t scope = used;
+        slots.pushSegment();
+        for (auto& e : block->block)
+            visit_statement(e);
+        slots.popSegment();
+        used = scope;
+    }
+
+    void SlotResolver::visit(For* f) {}
+}
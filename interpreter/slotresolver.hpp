@@ -0,0 +1,31 @@
+#pragma once
+#include "ast/treevisitor.hpp"
+#include "ast/functionnode.hpp"
+#include "parser/symbolstack.hpp"
+
+namespace kvantum::interpreter
+{
+    /*
+        gives every parameter and local of a type checked function a fixed frame slot
+        and records it on the Variable nodes, the parameters take the first slots
+        and sibling blocks reuse the slots of each other
+    */
+    class SlotResolver : public TreeVisitor
+    {
+    IMPLEMENTS_TREE_VISITOR
+    public:
+        ///resolves the function once, later calls return immediately
+        static void resolve(FunctionNode* f);
+
+    private:
+        explicit SlotResolver(FunctionNode* f) : function(f) {}
+        void resolve();
+        uint16_t declare(Variable* var);
+
+        FunctionNode* function;
+        parser::SymbolStack<uint16_t> slots;
+        ///slots below it belong to declarations in scope
+        uint16_t used = 0;
+        uint16_t frameSize = 0;
+    };
+}
@@ -4,146 +4,176 @@
 
 namespace kvantum::interpreter
 {
-   struct IntValue;
-   struct RatValue;
    struct StrValue;
-   struct BoolValue;
-   struct ObjectValue;
-   struct VoidValue;
    struct ArrayValue;
+   struct ObjectValue;
 
+   /*
+      16 byte tagged value passed by copy, numbers and booleans are stored inline
+      and only strings, arrays and objects point to a heap cell, Int is 64 bit like the long
+      it is generated as in C
+   */
    struct Value
    {
-      virtual bool isInt(){ return false; }
-      virtual bool isRat(){ return false; }
-      virtual bool isStr(){ return false; }
-      virtual bool isBool(){ return false; }
-      virtual bool isObj(){ return false; }
-      virtual bool isVoid() { return false; }
-      virtual bool isArray() { return false; }
-
-      virtual IntValue* asInt();
-      virtual RatValue* asRat();
-      virtual StrValue* asStr();
-      virtual BoolValue* asBool();
-      virtual ObjectValue* asObj();
-      virtual VoidValue* asVoid();
-      virtual ArrayValue* asArray();
-
-      virtual Value* add(Value* v) { throw std::invalid_argument("cannot add"); }
-      virtual Value* sub(Value* v) { throw std::invalid_argument("cannot sub"); }
-      virtual Value* mul(Value* v) { throw std::invalid_argument("cannot mul"); }
-      virtual Value* div(Value* v) { throw std::invalid_argument("cannot div"); }
-
-      virtual IntValue* convertToInt(Value* v) { throw std::invalid_argument("cannot convert"); }
-      virtual RatValue* convertToRat(Value* v) { throw std::invalid_argument("cannot convert"); }
-      virtual StrValue* convertToStr(Value* v) { throw std::invalid_argument("cannot convert"); }
-      virtual BoolValue* convertToBool(Value* v) { throw std::invalid_argument("cannot convert"); }
-      virtual VoidValue* convertToVoid(Value* v) { throw std::invalid_argument("cannot convert"); }
-      virtual ObjectValue* convertToObj(Value* v) { throw std::invalid_argument("cannot convert"); }
-
-      virtual int compare(Value* v) { throw std::invalid_argument("cannot compare"); }
+      enum Tag : uint8_t { VOID, INT, RAT, BOOL, STR, ARRAY, OBJECT };
+
+      Value() : tag(VOID), rat(0) {}
+      Value(int v) : tag(INT), integer(v) {}
+      Value(int64_t v) : tag(INT), integer(v) {}
+      Value(double v) : tag(RAT), rat(v) {}
+      Value(bool v) : tag(BOOL), boolean(v) {}
+      Value(StrValue* v) : tag(STR), str(v) {}
+      Value(ArrayValue* v) : tag(ARRAY), array(v) {}
+      Value(ObjectValue* v) : tag(OBJECT), obj(v) {}
+      ///a string literal would silently become a bool
+      Value(const char*) = delete;
+
+      bool isInt() const { return tag == INT; }
+      bool isRat() const { return tag == RAT; }
+      bool isStr() const { return tag == STR; }
+      bool isBool() const { return tag == BOOL; }
+      bool isObj() const { return tag == OBJECT; }
+      bool isVoid() const { return tag == VOID; }
+      bool isArray() const { return tag == ARRAY; }
+
+      ///the accessors do not check the tag, the type checker already did
+      int64_t asInt() const { return integer; }
+      double asRat() const { return rat; }
+      bool asBool() const { return boolean; }
+      StrValue* asStr() const { return str; }
+      ArrayValue* asArray() const { return array; }
+      ObjectValue* asObj() const { return obj; }
+
+      inline Value add(const Value& v) const;
+      inline Value sub(const Value& v) const;
+      inline Value mul(const Value& v) const;
+      inline Value div(const Value& v) const;
+      inline int compare(const Value& v) const;
+
+      Tag tag;
+      union
+      {
+         int64_t integer;
+         double rat;
+         bool boolean;
+         StrValue* str;
+         ArrayValue* array;
+         ObjectValue* obj;
+      };
    };
+   static_assert(sizeof(Value) == 16, "values are passed in two registers");
 
-   struct IntValue : public Value
+   ///header of the heap part of a value, the cells of a heap are linked for sweeping
+   struct HeapCell
    {
-   public:
-      IntValue(int v) : value(v){}
-      bool isInt(){ return true; }
-      virtual Value* add(Value* v) { return new IntValue(value + v->asInt()->value); }
-      virtual Value* sub(Value* v) { return new IntValue(value - v->asInt()->value); }
-      virtual Value* mul(Value* v) { return new IntValue(value * v->asInt()->value); }
-      virtual Value* div(Value* v) { return new IntValue(value / v->asInt()->value); }
-      
-
-      virtual int compare(Value* v) 
-      {
-         if(v->asInt()->value < value)
-            return 1;
-         if(v->asInt()->value > value)
-            return -1;
-         return 0;
-      }
+      enum Kind : uint8_t { STR, ARRAY, OBJECT };
+
+      explicit HeapCell(Kind kind) : kind(kind) {}
 
-      int value;
+      HeapCell* next = nullptr;
+      Kind kind;
+      bool marked = false;
    };
 
-   struct RatValue : public Value
+   struct StrValue : public HeapCell
    {
-      RatValue(double v) : value(v){}
-      virtual Value* add(Value* v) { return new RatValue(value + v->asRat()->value); }
-      virtual Value* sub(Value* v) { return new RatValue(value - v->asRat()->value); }
-      virtual Value* mul(Value* v) { return new RatValue(value * v->asRat()->value); }
-      virtual Value* div(Value* v) { return new RatValue(value / v->asRat()->value); }
-         
-      virtual int compare(Value* v) 
-      {
-         if(v->asRat()->value < value)
-            return 1;
-         if(v->asRat()->value > value)
-            return -1;
-         return 0;
-      }  
-
-      double value;
+      explicit StrValue(string v) : HeapCell(STR), value(std::move(v)) {}
+
+      string value;
    };
 
-   struct StrValue : public Value
+   struct ArrayValue : public HeapCell
    {
-      StrValue(string v) : value(v){}
-      virtual Value* add(Value* v) { return new StrValue(value + v->asStr()->value); }
+      explicit ArrayValue(vector<Value> v) : HeapCell(ARRAY), values(std::move(v)) {}
 
-      virtual int compare(Value* v) 
+      Value index(int64_t ind) const
       {
-         if(v->asStr()->value.size() < value.size())
-            return 1;
-         if(v->asStr()->value.size() > value.size())
-            return -1;
-         return 0;
-      }  
+         if (ind < 0 || values.size() <= (size_t) ind)
+            throw std::invalid_argument("index out of range for array");
+         return values[ind];
+      }
 
-      string value;
+      vector<Value> values;
    };
 
-   struct BoolValue : public Value
+   struct ObjectLayout;
+   struct ObjectValue : public HeapCell
    {
-      BoolValue(bool v) : value(v){}
-      virtual Value* add(Value* v) { return new BoolValue(value || v->asBool()->value); }
-      virtual Value* mul(Value* v) { return new BoolValue(value && v->asBool()->value); }
-      bool invert() { return new BoolValue(!value); }
+      explicit ObjectValue(const ObjectLayout& layout);
 
-      virtual int compare(Value* v) 
-      {
-         return !v->asBool()->value == value;
-      }  
+      const ObjectLayout& layout;
+      ///one slot per field of the type, laid out by the ObjectLayout
+      vector<Value> fields;
+   };
 
+   ///allocates a string in the heap active on this thread
+   StrValue* newString(string value);
 
-      bool value;
-   };
+   ///Int arithmetic wraps around instead of overflowing, which would be undefined
+   static int64_t wrapping(uint64_t v)
+   {
+      return (int64_t) v;
+   }
 
-   struct ObjectValue : public Value
+   template<typename T>
+   static int compareValues(T lhs, T rhs)
    {
-      ObjectValue(ObjectType* t){ type = t; }
+      return lhs < rhs ? -1 : rhs < lhs ? 1 : 0;
+   }
 
-      virtual int compare(Value* v){ return 0; }
+   Value Value::add(const Value& v) const
+   {
+      switch (tag) {
+      case INT: return Value(wrapping((uint64_t) integer + (uint64_t) v.integer));
+      case RAT: return Value(rat + v.rat);
+      case BOOL: return Value(boolean || v.boolean);
+      case STR: return Value(newString(str->value + v.str->value));
+      default: throw std::invalid_argument("cannot add");
+      }
+   }
 
-      ObjectType* type;
-   };
+   Value Value::sub(const Value& v) const
+   {
+      switch (tag) {
+      case INT: return Value(wrapping((uint64_t) integer - (uint64_t) v.integer));
+      case RAT: return Value(rat - v.rat);
+      default: throw std::invalid_argument("cannot sub");
+      }
+   }
 
-   struct ArrayValue : public Value
+   Value Value::mul(const Value& v) const
    {
-       ArrayValue(vector<Value*> *vals) :value_ptr(vals){}
-
-       Value* index(int ind)
-       { 
-           if (value_ptr->size() <= ind)
-               throw std::invalid_argument("index out of range for array");
-           return (*value_ptr)[ind];
-       }
-       vector<Value*>* value_ptr;
-   };
+      switch (tag) {
+      case INT: return Value(wrapping((uint64_t) integer * (uint64_t) v.integer));
+      case RAT: return Value(rat * v.rat);
+      case BOOL: return Value(boolean && v.boolean);
+      default: throw std::invalid_argument("cannot mul");
+      }
+   }
 
-   struct VoidValue : public Value 
+   Value Value::div(const Value& v) const
    {
-   };
-}
\ No newline at end of file
+      switch (tag) {
+      case INT:
+         if (v.integer == 0)
+            throw std::invalid_argument("division by zero");
+         if (integer == INT64_MIN && v.integer == -1)
+            throw std::invalid_argument("integer overflow in division");
+         return Value(integer / v.integer);
+      case RAT: return Value(rat / v.rat);
+      default: throw std::invalid_argument("cannot div");
+      }
+   }
+
+   int Value::compare(const Value& v) const
+   {
+      switch (tag) {
+      case INT: return compareValues(integer, v.integer);
+      case RAT: return compareValues(rat, v.rat);
+      case BOOL: return boolean != v.boolean;
+      case STR: return compareValues(str->value.size(), v.str->value.size());
+      case OBJECT: return 0;
+      default: throw std::invalid_argument("cannot compare");
+      }
+   }
+}
@@ -0,0 +1,318 @@
+#include "interpreter/vm.hpp"
+#include "interpreter/bytecodecompiler.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define KVANTUM_THREADED_DISPATCH 1
+#else
+#define KVANTUM_THREADED_DISPATCH 0
+#endif
+
+namespace kvantum::interpreter
+{
+    static Value castValue(Value v, PrimitiveType::TypeBase to)
+    {
+        switch (to) {
+        case PrimitiveType::Integer:
+            return v.isRat() ? Value((int64_t) v.asRat()) : v;
+        case PrimitiveType::Float:
+            return v.isInt() ? Value((double) v.asInt()) : v;
+        default:
+            return v;
+        }
+    }
+
+    void VirtualMachine::generate(Module* mod)
+    {
+        this->mod = mod;
+        Heap::Activation activation(heap);
+        constants.load(mod->getMainFunction());
+        program.indexOf(mod->getMainFunction());
+        compilePending();
+    }
+
+    void VirtualMachine::generateFunction(FunctionNode* f)
+    {
+        Heap::Activation activation(heap);
+        constants.load(f);
+        program.indexOf(f);
+        compilePending();
+    }
+
+    void VirtualMachine::prototypeFunction(FunctionNode* f)
+    {
+        program.indexOf(f);
+    }
+
+    void VirtualMachine::generateObject(ObjectType* t) {}
+
+    void VirtualMachine::compilePending()
+    {
+        BytecodeCompiler compiler(program, builtins, constants);
+        ///compiling a function can reference new ones, so the size is read on every iteration
+        for (size_t i = 0; i < program.functions.size(); i++) {
+            if (!program.functions[i]->compiled)
+                compiler.compile(*program.functions[i]);
+        }
+    }
+
+    void VirtualMachine::exec()
+    {
+        Heap::Activation activation(heap);
+        auto& main = *program.functions[program.indexOf(mod->getMainFunction())];
+        frames.clear();
+        top = 0;
+        result = run(main, nullptr);
+    }
+
+    Value VirtualMachine::call(FunctionNode* f, const vector<Value>& args)
+    {
+        Heap::Activation activation(heap);
+        constants.load(f);
+        auto& func = *program.functions[program.indexOf(f)];
+        compilePending();
+        if (args.size() != func.paramCount)
+            throw RuntimeError("wrong number of arguments for " + f->getName());
+        return run(func, args.data());
+    }
+
+    void VirtualMachine::collectGarbage()
+    {
+        heap.collect([this](Heap& heap) {
+            std::for_each(registers.begin(), registers.begin() + top, [&heap](const Value& v) { heap.mark(v); });
+            for (auto& f : program.functions)
+                for (auto& e : f->constants)
+                    heap.mark(e);
+            heap.mark(result);
+            constants.mark(heap);
+        });
+    }
+
+    BytecodeFunction* VirtualMachine::resolveVirtual(FunctionNode* method, ObjectType& receiver)
+    {
+        auto& target = *program.functions[program.indexOf(resolveOverride(method, receiver))];
+        if (!target.compiled)
+            compilePending();
+        return &target;
+    }
+
+    void VirtualMachine::pushFrame(const BytecodeFunction& callee, size_t args, uint16_t result)
+    {
+        if (frames.size() >= maxCallDepth)
+            throw std::invalid_argument("call stack overflow calling " + callee.source->getName());
+        size_t base = top;
+        top += callee.registerCount;
+        if (top > registers.size())
+            registers.resize(std::max(top, 2 * registers.size()));
+        std::copy_n(registers.begin() + args, callee.paramCount, registers.begin() + base);
+        ///the registers still hold values of returned calls, which the collector may have freed since
+        std::fill(registers.begin() + base + callee.paramCount, registers.begin() + top, Value());
+        frames.push_back({&callee, nullptr, base, result});
+    }
+
+    Value VirtualMachine::run(const BytecodeFunction& entry, const Value* args)
+    {
+        size_t depth = frames.size();
+        size_t bottom = top;
+        ///the arguments may live in the register stack, which can move while the frame is pushed
+        vector<Value> arguments(args, args + entry.paramCount);
+        top += entry.paramCount;
+        if (top > registers.size())
+            registers.resize(std::max(top, 2 * registers.size()));
+        std::copy(arguments.begin(), arguments.end(), registers.begin() + bottom);
+        pushFrame(entry, bottom, 0);
+
+        const BytecodeFunction* func;
+        Value* r;
+        const Value* k;
+        const Instruction* code;
+        const Instruction* ip;
+        const Instruction* in = nullptr;
+        ///the register stack can move on every call, so the frame is reloaded after calls and returns
+        auto load = [&]() {
+            func = frames.back().func;
+            r = registers.data() + frames.back().base;
+            k = func->constants.data();
+            code = func->code.data();
+        };
+        Value returned;
+        ///pops the frame, true once the entry function itself returned
+        auto leave = [&](Value value) {
+            Frame done = frames.back();
+            frames.pop_back();
+            top = done.base;
+            if (frames.size() == depth) {
+                top = bottom;
+                returned = value;
+                return true;
+            }
+            load();
+            ip = frames.back().ip;
+            r[done.result] = value;
+            return false;
+        };
+        load();
+        ip = code;
+
+#if KVANTUM_THREADED_DISPATCH
+        static const void* labels[] = {
+#define KVANTUM_OPCODE_LABEL(name) &&op_##name,
+            KVANTUM_OPCODES(KVANTUM_OPCODE_LABEL)
+#undef KVANTUM_OPCODE_LABEL
+        };
+#define VM_CASE(name) op_##name:
+#define VM_NEXT() \
+    in = ip++; \
+    goto *labels[(size_t) in->op]
+#else
+#define VM_CASE(name) case OpCode::name:
+#define VM_NEXT() continue
+#endif
+
+        try {
+#if KVANTUM_THREADED_DISPATCH
+            VM_NEXT();
+#else
+            for (;;) {
+                in = ip++;
+                switch (in->op) {
+#endif
+            VM_CASE(MOVE)
+                r[in->a] = r[in->b];
+                VM_NEXT();
+            VM_CASE(LOADK)
+                r[in->a] = k[in->b];
+                VM_NEXT();
+            VM_CASE(ADD)
+                r[in->a] = r[in->b].add(r[in->c]);
+                VM_NEXT();
+            VM_CASE(SUB)
+                r[in->a] = r[in->b].sub(r[in->c]);
+                VM_NEXT();
+            VM_CASE(MUL)
+                r[in->a] = r[in->b].mul(r[in->c]);
+                VM_NEXT();
+            VM_CASE(DIV)
+                r[in->a] = r[in->b].div(r[in->c]);
+                VM_NEXT();
+            VM_CASE(EQ)
+                r[in->a] = Value(r[in->b].compare(r[in->c]) == 0);
+                VM_NEXT();
+            VM_CASE(NE)
+                r[in->a] = Value(r[in->b].compare(r[in->c]) != 0);
+                VM_NEXT();
+            VM_CASE(LT)
+                r[in->a] = Value(r[in->b].compare(r[in->c]) < 0);
+                VM_NEXT();
+            VM_CASE(LE)
+                r[in->a] = Value(r[in->b].compare(r[in->c]) <= 0);
+                VM_NEXT();
+            VM_CASE(GT)
+                r[in->a] = Value(r[in->b].compare(r[in->c]) > 0);
+                VM_NEXT();
+            VM_CASE(GE)
+                r[in->a] = Value(r[in->b].compare(r[in->c]) >= 0);
+                VM_NEXT();
+            VM_CASE(JMP)
+                ///loops and calls are the safe points, every live value is in a register there
+                if (heap.shouldCollect())
+                    collectGarbage();
+                ip = code + in->target();
+                VM_NEXT();
+            VM_CASE(JMPF)
+                if (!r[in->a].asBool())
+                    ip = code + in->target();
+                VM_NEXT();
+            VM_CASE(JMPT)
+                if (r[in->a].asBool())
+                    ip = code + in->target();
+                VM_NEXT();
+            VM_CASE(CALL)
+                if (heap.shouldCollect())
+                    collectGarbage();
+                frames.back().ip = ip;
+                pushFrame(*program.functions[in->b], frames.back().base + in->c, in->a);
+                load();
+                ip = code;
+                VM_NEXT();
+            VM_CASE(TAILCALL)
+            {
+                if (heap.shouldCollect())
+                    collectGarbage();
+                ///the callee takes over the frame, the caller of this frame receives its result
+                const BytecodeFunction& callee = *program.functions[in->b];
+                std::copy_n(r + in->c, callee.paramCount, r);
+                size_t base = frames.back().base;
+                top = base + callee.registerCount;
+                if (top > registers.size())
+                    registers.resize(std::max(top, 2 * registers.size()));
+                std::fill(registers.begin() + base + callee.paramCount, registers.begin() + top, Value());
+                frames.back().func = &callee;
+                load();
+                ip = code;
+                VM_NEXT();
+            }
+            VM_CASE(CALLVIRT)
+            {
+                if (heap.shouldCollect())
+                    collectGarbage();
+                const Value& self = r[in->c];
+                if (!self.isObj())
+                    throw std::invalid_argument("cannot call a method on a non-object");
+                auto& call = *program.virtualCalls[in->b];
+                auto target = call.receivers.lookup(self.asObj()->layout.type, [this, &call](ObjectType& receiver) {
+                    return resolveVirtual(call.method, receiver);
+                });
+                frames.back().ip = ip;
+                pushFrame(*target, frames.back().base + in->c, in->a);
+                load();
+                ip = code;
+                VM_NEXT();
+            }
+            VM_CASE(NATIVE)
+            {
+                const NativeCall& call = program.natives[in->b];
+                r[in->a] = builtins.call(call.id, r + in->c, call.argCount);
+                VM_NEXT();
+            }
+            VM_CASE(INDEX)
+                r[in->a] = r[in->b].asArray()->index(r[in->c].asInt());
+                VM_NEXT();
+            VM_CASE(NEWARRAY)
+                r[in->a] = heap.allocateArray(vector<Value>(r + in->b, r + in->b + in->c));
+                VM_NEXT();
+            VM_CASE(NEWOBJECT)
+                r[in->a] = heap.allocateObject(*program.layouts[in->b]);
+                VM_NEXT();
+            VM_CASE(GETFIELD)
+                r[in->a] = r[in->b].asObj()->fields[in->c];
+                VM_NEXT();
+            VM_CASE(SETFIELD)
+                r[in->a].asObj()->fields[in->b] = r[in->c];
+                VM_NEXT();
+            VM_CASE(CAST)
+                r[in->a] = castValue(r[in->b], (PrimitiveType::TypeBase) in->c);
+                VM_NEXT();
+            VM_CASE(RET)
+                if (leave(r[in->a]))
+                    return returned;
+                VM_NEXT();
+            VM_CASE(RETVOID)
+                if (leave(Value()))
+                    return returned;
+                VM_NEXT();
+#if !KVANTUM_THREADED_DISPATCH
+                }
+            }
+#endif
+        } catch (std::invalid_argument& e) {
+            ///the innermost frame raised it, the frames of this run are dropped
+            unsigned int line = in ? func->lines[in - code] : 0;
+            string name = func->source->getName();
+            frames.resize(depth);
+            top = bottom;
+            throw RuntimeError(string(e.what()) + " in " + name + " at line " + std::to_string(line));
+        }
+#undef VM_CASE
+#undef VM_NEXT
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "interpreter/bytecode.hpp"
+#include "interpreter/interpreter.hpp"
+
+namespace kvantum::interpreter
+{
+    /*
+        executes the register bytecode, functions are lowered on first reference,
+        the dispatch loop is threaded with computed gotos where the compiler supports them,
+        calls push a frame on a heap allocated stack so the host stack does not grow with the recursion
+    */
+    class VirtualMachine : public codegen::CodeExecutorInterface
+    {
+    public:
+        void generate(Module* mod) override;
+        void generateFunction(FunctionNode* f) override;
+        void prototypeFunction(FunctionNode* f) override;
+        void generateObject(ObjectType* t) override;
+        void exec() override;
+
+        ///value returned by the main function of the last exec
+        Value getResult() const { return result; }
+        ///compiles the function if needed and runs it on the arguments, throws RuntimeError
+        Value call(FunctionNode* f, const vector<Value>& args);
+        void setMaxCallDepth(size_t depth) { maxCallDepth = depth; }
+
+        ///deeper recursion is reported as a runtime error instead of exhausting the memory
+        static constexpr size_t MAX_CALL_DEPTH = 1 << 22;
+
+    private:
+        ///an active call, its registers start at base in the register stack
+        struct Frame
+        {
+            const BytecodeFunction* func;
+            ///where the caller continues once the callee returns
+            const Instruction* ip;
+            size_t base;
+            ///register of the caller receiving the result
+            uint16_t result;
+        };
+
+        ///lowers every referenced function which is not compiled yet
+        void compilePending();
+        ///runs until the function returns, calls made by it do not recurse on the host stack
+        Value run(const BytecodeFunction& func, const Value* args);
+        ///the arguments are the registers starting at args in the register stack
+        void pushFrame(const BytecodeFunction& callee, size_t args, uint16_t result);
+        void collectGarbage();
+        ///compiles the override on the first dispatch to it
+        BytecodeFunction* resolveVirtual(FunctionNode* method, ObjectType& receiver);
+
+        Module* mod = nullptr;
+        Program program;
+        Heap heap;
+        ConstantPool constants;
+        ///registers of every active call below top, the roots of the heap together with the constants
+        vector<Value> registers;
+        size_t top = 0;
+        vector<Frame> frames;
+        VirtualFunctionInterpreter builtins;
+        Value result;
+        size_t maxCallDepth = MAX_CALL_DEPTH;
+    };
+}
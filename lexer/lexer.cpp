@@ -1,54 +1,43 @@
 #include "lexer/lexer.hpp"
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstring>
 
 namespace kvantum::lexer
 {
-    Lexer::Lexer(Lexer &lexer)
-        : Lexer(lexer.tokens)
-    {}
-
     Lexer::Lexer(const string &file_name)
     {
-        regexes.resize(Token::END_OF_FILE);
         file = file_name;
-        initializeRegexes();
-        lineIndex = 1;
-        err = false;
-        is.open(file_name);
-        if (is.fail()) {
+        source = SourceBuffer::open(file_name);
+        if (!source) {
             err = true;
             panic("cannot open file " + file_name);
+            return;
         }
-        lex();
+        text = source->getText();
     }
 
-    Lexer::Lexer(queue<Token> &toks)
-        : tokens(std::move(toks))
-        , err(false)
-        , lineIndex(0)
-    {
-        lex();
-    }
-
-    Lexer::~Lexer()
-    {
-        is.close();
-    }
+    Lexer::~Lexer() = default;
 
     Token Lexer::nextToken()
     {
         Token t = lookAhead();
-        tokens.pop();
+        ringHead = (ringHead + 1) % LOOKAHEAD_SIZE;
+        ringSize--;
+        if (t.type == Token::END_OF_FILE)
+            consumedEnd = true;
+        ///nodes built from this token take their line from the context
+        DiagnosticContext::current().setLineIndex(t.lineIndex);
         return t;
     }
 
     Token Lexer::lookAhead()
     {
-        if (tokens.empty())
+        if (consumedEnd)
             throw UnexpectedEndOfTokens();
-        auto t = tokens.front();
-        kvantum::Diagnostics::setLineIndex(t.lineIndex);
-        kvantum::Diagnostics::setWorkingModule(t.filename);
-        return t;
+        fill(1);
+        return ring[ringHead];
     }
 
     std::optional<Token> Lexer::consumeIf(Token::TokenType t)
@@ -67,124 +56,219 @@ namespace kvantum::lexer
 
     bool Lexer::end()
     {
-        return tokens.empty() || tokens.front().type == Token::END_OF_FILE;
+        return consumedEnd || lookAhead().type == Token::END_OF_FILE;
     }
 
     void Lexer::printTokens()
     {
-        Token tok;
-        queue<Token> toks(tokens);
-        while (!toks.empty()) {
-            tok = toks.front();
-            toks.pop();
-            Diagnostics::log(tok.typeToString() + " " + tok.value);
+        Lexer lexer(file);
+        while (!lexer.end()) {
+            Token tok = lexer.nextToken();
+            Diagnostics::log(tok.typeToString() + " " + string(tok.value));
         }
     }
 
-    void Lexer::initializeRegexes()
+    void Lexer::fill(size_t n)
     {
-        setRegex(Token::RATIONAL, "[0-9]+\\.[0-9]*");
-        setRegex(Token::INTEGER, R"([1-9]+[0-9]*|0)");
-        setRegex(Token::BOOLEAN, "(True|False)");
-        setRegex(Token::STRING, R"(\".*\")");
-        setRegex(Token::NONE, "None");
-        setRegex(Token::EQUALS, "=");
-        setRegex(Token::PLUS, "\\+");
-        setRegex(Token::MINUS, "-");
-        setRegex(Token::MULTIPLY, "\\*");
-        setRegex(Token::DIVIDE, "/");
-        setRegex(Token::LESS_T, "<");
-        setRegex(Token::LESS_OR_EQ_T, "<=");
-        setRegex(Token::GREATER_T, ">");
-        setRegex(Token::GREATER_OR_EQ_T, ">=");
-        setRegex(Token::LOG_EQUAL, "==");
-        setRegex(Token::LOG_N_EQUAL, "!=");
-        setRegex(Token::AND, "and");
-        setRegex(Token::OR, "or");
-        setRegex(Token::NOT, "not");
-        setRegex(Token::L_BRACKET, "\\(");
-        setRegex(Token::R_BRACKET, "\\)");
-        setRegex(Token::LC_BRACKET, "\\{");
-        setRegex(Token::RC_BRACKET, "\\}");
-        setRegex(Token::LSQ_BRACKET, "\\[");
-        setRegex(Token::RSQ_BRACKET, "\\]");
-        setRegex(Token::DOT, "\\.");
-        setRegex(Token::COLON, ":");
-        setRegex(Token::COMMA, ",");
-        setRegex(Token::SEMI_COLON, ";");
-        setRegex(Token::AS, "as");
-        setRegex(Token::LET, "let");
-        setRegex(Token::ANNOTATION, "@[a-z]+");
-        setRegex(Token::WHILE, "while");
-        setRegex(Token::FOR, "for");
-        setRegex(Token::IF, "if");
-        setRegex(Token::ELSE, "else");
-        setRegex(Token::FUNCTION, "fn");
-        setRegex(Token::TYPE, "type");
-        setRegex(Token::RETURN, "return");
-        setRegex(Token::ARROW, "->");
-        setRegex(Token::BACK_ARROW, "<-");
-        setRegex(Token::DUAL_ARROW, "=>");
-        setRegex(Token::AMPERSAND, "&");
-        setRegex(Token::NAMESPACE_SCOPE, "::");
-        setRegex(Token::USE, "use");
-        setRegex(Token::EXTERN, "external");
-        setRegex(Token::IDENTIFIER, "[a-zA-Z_][a-zA-Z0-9_]*");
+        ///past the end of the file scanToken keeps producing END_OF_FILE tokens
+        while (ringSize < n) {
+            ring[(ringHead + ringSize) % LOOKAHEAD_SIZE] = scanToken();
+            ringSize++;
+        }
     }
 
-    void Lexer::setRegex(Token::TokenType token, string reg)
+    /*
+        scans the whole buffer without the lookahead window, at least MIN_PASSES times
+        and for MIN_TIME, the fastest pass is reported
+    */
+    bool Lexer::benchmark(const string &file_name)
     {
-        regexes[token] = new std::regex("^" + reg + "$");
-    }
+        const unsigned int MIN_PASSES = 5;
+        const std::chrono::duration<double> MIN_TIME(0.5);
 
-    void Lexer::lex()
-    {
-        string line;
-        while (std::getline(is, line)) {
-            auto parts = std_string_split(line);
-            for (auto &e : parts) {
-                tokenize(e);
-            }
-            lineIndex++;
+        const SourceBuffer *source = SourceBuffer::open(file_name);
+        if (!source) {
+            std::cerr << "cannot open file " << file_name << std::endl;
+            return false;
+        }
+        string_view text = source->getText();
+
+        size_t tokens = 0;
+        std::chrono::duration<double> best = std::chrono::duration<double>::max(), total{};
+        for (unsigned int pass = 0; pass < MIN_PASSES || total < MIN_TIME; pass++) {
+            Lexer lexer;
+            lexer.source = source;
+            lexer.text = text;
+            tokens = 0;
+            auto begin = std::chrono::steady_clock::now();
+            while (lexer.scanToken().type != Token::END_OF_FILE)
+                tokens++;
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+            best = std::min(best, elapsed);
+            total += elapsed;
         }
-        tokens.emplace(Token::END_OF_FILE, "", file);
+
+        double megabytes = text.size() / (1024.0 * 1024.0);
+        std::cout << file_name << ": " << text.size() << " bytes, " << tokens << " tokens, "
+                  << megabytes / std::max(best.count(), 1e-9) << " MB/s" << std::endl;
+        return true;
     }
 
-    void Lexer::tokenize(const string &line)
+    /*
+        hand written DFA over the source buffer, every token is matched with maximal munch
+        so the result is the same as trying every token pattern and keeping the longest match
+    */
+    Token Lexer::scanToken()
     {
-        std::function<int(const string &)> tokenizePart = [this, &tokenizePart](const string &line) {
-            if (line.empty())
-                return 0;
-            Token::TokenType type;
-            if (match(line, type)) {
-                tokens.emplace(type, line, file, lineIndex);
-                return (int) line.size();
-            } else {
-                return tokenizePart(line.substr(0, line.size() - 1));
+        auto isIdentBegin = [](char c) { return std::isalpha((unsigned char) c) || c == '_'; };
+        auto isIdent = [](char c) { return std::isalnum((unsigned char) c) || c == '_'; };
+        auto isDigit = [](char c) { return std::isdigit((unsigned char) c); };
+
+        const char *src = text.data();
+        const size_t size = text.size();
+        size_t &i = pos;
+        while (i < size) {
+            const char c = src[i];
+            if (c == '\n') {
+                lineIndex++;
+                i++;
+                continue;
+            }
+            if (std::isspace((unsigned char) c)) {
+                i++;
+                continue;
             }
-        };
 
-        int idx = 0;
-        while (idx < line.size()) {
-            int incr = tokenizePart(line.substr(idx));
-            if (!incr) {
-                panic("could not tokenize " + line.substr(incr));
-                err = true;
-                return;
+            size_t begin = i;
+            Token::TokenType type;
+            if (isIdentBegin(c)) {
+                while (i < size && isIdent(src[i]))
+                    i++;
+                type = keyword(src + begin, i - begin);
+            } else if (isDigit(c)) {
+                while (i < size && isDigit(src[i]))
+                    i++;
+                type = Token::INTEGER;
+                if (i < size && src[i] == '.') {
+                    i++;
+                    while (i < size && isDigit(src[i]))
+                        i++;
+                    type = Token::RATIONAL;
+                }
+            } else if (c == '"') {
+                i++;
+                while (i < size && src[i] != '"' && src[i] != '\n')
+                    i++;
+                if (i == size || src[i] != '"') {
+                    Diagnostics::setLineIndex(lineIndex);
+                    panic("could not tokenize " + string(text.substr(begin, i - begin)));
+                    err = true;
+                    continue;
+                }
+                i++;
+                type = Token::STRING;
+            } else if (c == '@') {
+                i++;
+                while (i < size && std::islower((unsigned char) src[i]))
+                    i++;
+                type = Token::ANNOTATION;
+            } else {
+                auto next = [&](char n) { return i + 1 < size && src[i + 1] == n; };
+                type = Token::END_OF_FILE;
+                switch (c) {
+                    CASE('+', type = Token::PLUS);
+                    CASE('*', type = Token::MULTIPLY);
+                    CASE('/', type = Token::DIVIDE);
+                    CASE('(', type = Token::L_BRACKET);
+                    CASE(')', type = Token::R_BRACKET);
+                    CASE('{', type = Token::LC_BRACKET);
+                    CASE('}', type = Token::RC_BRACKET);
+                    CASE('[', type = Token::LSQ_BRACKET);
+                    CASE(']', type = Token::RSQ_BRACKET);
+                    CASE('.', type = Token::DOT);
+                    CASE(',', type = Token::COMMA);
+                    CASE(';', type = Token::SEMI_COLON);
+                    CASE('&', type = Token::AMPERSAND);
+                    CASE('-', type = next('>') ? Token::ARROW : Token::MINUS);
+                    CASE(':', type = next(':') ? Token::NAMESPACE_SCOPE : Token::COLON);
+                    CASE('!', type = next('=') ? Token::LOG_N_EQUAL : Token::END_OF_FILE);
+                    CASE('>', type = next('=') ? Token::GREATER_OR_EQ_T : Token::GREATER_T);
+                    CASE('=',
+                         type = next('=')   ? Token::LOG_EQUAL
+                                : next('>') ? Token::DUAL_ARROW
+                                            : Token::EQUALS);
+                    CASE('<',
+                         type = next('=')   ? Token::LESS_OR_EQ_T
+                                : next('-') ? Token::BACK_ARROW
+                                            : Token::LESS_T);
+                default:
+                    break;
+                }
+                if (type == Token::END_OF_FILE) {
+                    Diagnostics::setLineIndex(lineIndex);
+                    panic("could not tokenize " + string(1, c));
+                    err = true;
+                    while (i < size && !std::isspace((unsigned char) src[i]))
+                        i++;
+                    continue;
+                }
+                i += type == Token::LOG_N_EQUAL || type == Token::GREATER_OR_EQ_T
+                             || type == Token::LOG_EQUAL || type == Token::DUAL_ARROW
+                             || type == Token::LESS_OR_EQ_T || type == Token::BACK_ARROW
+                             || type == Token::ARROW || type == Token::NAMESPACE_SCOPE
+                         ? 2
+                         : 1;
             }
-            idx += incr;
+            Token tok(type, text.substr(begin, i - begin), source->getID(), lineIndex);
+            if (type == Token::IDENTIFIER)
+                tok.symbol = SymbolTable::intern(tok.value);
+            return tok;
         }
+        return Token(Token::END_OF_FILE, "", source ? source->getID() : Token::NO_FILE);
     }
 
-    bool Lexer::match(const string &str, Token::TokenType &type)
+    /*
+        perfect hash over the keyword set: (length + first + 2 * second char) mod 32
+        is collision free for every keyword, so a lookup is one hash and one compare
+    */
+    Token::TokenType Lexer::keyword(const char *str, size_t len)
     {
-        std::smatch match;
-        for (int i = 0; i < regexes.size(); i++) {
-            if (std::regex_match(str, match, *regexes[i])) {
-                type = static_cast<Token::TokenType>(i);
-                return true;
-            }
-        }
-        return false;
+        struct Keyword
+        {
+            const char *str = nullptr;
+            Token::TokenType type = Token::IDENTIFIER;
+        };
+        auto hash = [](const char *s, size_t l) {
+            return (l + (unsigned char) s[0] + 2 * (unsigned char) s[1]) & 31;
+        };
+        static const std::array<Keyword, 32> table = [&hash] {
+            std::array<Keyword, 32> t{};
+            for (auto &kw : {Keyword{"True", Token::BOOLEAN},
+                             Keyword{"False", Token::BOOLEAN},
+                             Keyword{"None", Token::NONE},
+                             Keyword{"and", Token::AND},
+                             Keyword{"or", Token::OR},
+                             Keyword{"not", Token::NOT},
+                             Keyword{"as", Token::AS},
+                             Keyword{"let", Token::LET},
+                             Keyword{"while", Token::WHILE},
+                             Keyword{"for", Token::FOR},
+                             Keyword{"if", Token::IF},
+                             Keyword{"else", Token::ELSE},
+                             Keyword{"fn", Token::FUNCTION},
+                             Keyword{"type", Token::TYPE},
+                             Keyword{"return", Token::RETURN},
+                             Keyword{"use", Token::USE},
+                             Keyword{"external", Token::EXTERN}})
+                t[hash(kw.str, std::strlen(kw.str))] = kw;
+            return t;
+        }();
+
+        if (len < 2)
+            return Token::IDENTIFIER;
+        auto &kw = table[hash(str, len)];
+        if (kw.str && std::strlen(kw.str) == len && std::memcmp(kw.str, str, len) == 0)
+            return kw.type;
+        return Token::IDENTIFIER;
     }
 }
@@ -2,53 +2,63 @@
 
 #include "common/token.hpp"
 #include "common/util.hpp"
+#include "lexer/sourcebuffer.hpp"
 #include <algorithm>
+#include <array>
 #include <memory>
 #include <optional>
-#include <queue>
-#include <regex>
 
-using std::queue;
 using std::string;
 namespace kvantum::lexer {
 
+/*
+    pull based token stream, tokens are scanned on demand from the source buffer
+    and only a bounded window of lookahead tokens is kept in memory
+*/
 class Lexer
 {
 public:
     class UnexpectedEndOfTokens : std::exception
     {};
 
-    Lexer(Lexer &lexer);
+    static constexpr size_t LOOKAHEAD_SIZE = 4;
+
     explicit Lexer(const std::string &file_name);
-    explicit Lexer(queue<Token> &toks);
     virtual ~Lexer();
 
-    Token nextToken();
-    Token lookAhead();
+    virtual Token nextToken();
+    virtual Token lookAhead();
     std::optional<Token> consumeIf(Token::TokenType t);
     void skipUntil(vector<Token::TokenType> t);
-    bool end();
+    virtual bool end();
 
     void printTokens();
+    ///lexes the file repeatedly and prints the best throughput in MB/s, returns false if it cannot be read
+    static bool benchmark(const string &file_name);
     constexpr bool hasError() const { return err; }
     string getFileName() const { return file; }
+    const SourceBuffer *getSource() const { return source; }
     string getModuleName() const { return file.substr(0, file.find('.')); }
 
-private:
-    void initializeRegexes();
-    void setRegex(Token::TokenType t, string reg);
+protected:
+    Lexer() = default;
 
-    void lex();
-    void tokenize(const std::string &line);
-    bool match(const string &string, Token::TokenType &type);
+private:
+    void fill(size_t n);
+    Token scanToken();
+    /// returns the keyword token type of the identifier or IDENTIFIER if its not a keyword
+    static Token::TokenType keyword(const char *str, size_t len);
 
-    vector<std::regex *> regexes;
     string file;
-    std::ifstream is;
-    int lineIndex;
-    bool err;
+    const SourceBuffer *source = nullptr;
+    string_view text;
+    size_t pos = 0;
+    unsigned int lineIndex = 1;
+    bool err = false;
 
-protected:
-    queue<Token> tokens;
+    std::array<Token, LOOKAHEAD_SIZE> ring;
+    size_t ringHead = 0;
+    size_t ringSize = 0;
+    bool consumedEnd = false;
 };
 } // namespace kvantum::lexer
@@ -3,16 +3,16 @@
 #include "lexer/lexer.hpp"
 #include <memory>
 #include <optional>
-#include <deque>
 
 using std::unique_ptr;
 using std::optional;
-using std::deque;
 
 namespace kvantum::lexer
 {
     /*
         contains a scope defined by the scope delimiter
+        its a view over the parent lexer, tokens are pulled from the parent on demand
+        and the view ends at the matching end delimiter
     */
     class Scope : public Lexer
     {
@@ -23,42 +23,83 @@ namespace kvantum::lexer
         {
             Token t = lexer.nextToken();
             while (t.type != begin) {
-                panic("symbol " + t.value + " is not a scope begin operator");
-                Token t = lexer.nextToken();
+                panic("symbol " + string(t.value) + " is not a scope begin operator");
+                if (lexer.end())
+                    return {};
+                t = lexer.nextToken();
             }
+            return std::make_unique<Scope>(lexer, t, end);
+        }
 
-            queue<Token> q;
-            q.push(t);
-            unsigned int scopeCtr = 1;
-            while (scopeCtr > 0) {
-                t = lexer.nextToken();
-                if (t.type == Token::END_OF_FILE) {
-                    panic("expected end of scope operator");
-                    return {};
-                }
+        Scope(Lexer &parent, Token beginToken, Token::TokenType end)
+            : parent(parent)
+            , beginToken(beginToken)
+            , endType(end)
+        {}
 
-                q.push(t);
-                if (t.type == end)
-                    scopeCtr--;
-                if (t.type == begin)
-                    scopeCtr++;
+        ///the parent always continues after the scope, even if the scope was not fully consumed
+        ~Scope() override
+        {
+            try {
+                while (depth > 0 && !parent.end())
+                    consume(parent.nextToken());
+            } catch (UnexpectedEndOfTokens &) {
             }
-            return std::make_unique<Scope>(q);
         }
 
-        ~Scope() override = default;
+        Token nextToken() override
+        {
+            Token t = lookAhead();
+            if (beginPending)
+                beginPending = false;
+            else
+                consume(parent.nextToken());
+            return t;
+        }
+
+        Token lookAhead() override
+        {
+            if (beginPending)
+                return beginToken;
+            if (depth == 0 || atEnd())
+                throw UnexpectedEndOfTokens();
+            return parent.lookAhead();
+        }
+
+        bool end() override { return !beginPending && (depth == 0 || atEnd()); }
 
         void dropScopeDelimitors()
         {
-            deque<Token> inner;
-            tokens.pop();
-            while (tokens.size() > 1) {
-                inner.push_back(tokens.front());
-                tokens.pop();
+            beginPending = false;
+            keepDelimitors = false;
+        }
+
+    private:
+        bool atEnd()
+        {
+            if (parent.end()) {
+                if (!unclosed)
+                    panic("expected end of scope operator");
+                unclosed = true;
+                return true;
             }
-            tokens = std::queue<Token>(inner);
+            return !keepDelimitors && depth == 1 && parent.lookAhead().type == endType;
+        }
+
+        void consume(const Token &t)
+        {
+            if (t.type == beginToken.type)
+                depth++;
+            else if (t.type == endType)
+                depth--;
         }
 
-        explicit Scope(queue<Token> &toks) : Lexer(toks) {}
+        Lexer &parent;
+        Token beginToken;
+        Token::TokenType endType;
+        unsigned int depth = 1;
+        bool beginPending = true;
+        bool keepDelimitors = true;
+        bool unclosed = false;
     };
 }
@@ -0,0 +1,92 @@
+#include "lexer/sourcebuffer.hpp"
+#include <algorithm>
+#include <mutex>
+
+#if !WINDOWS_PLATFORM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kvantum::lexer {
+
+static std::mutex buffersMutex;
+
+SourceBuffer::SourceBuffer(string fileName, FileID id)
+    : fileName(std::move(fileName))
+    , id(id)
+{}
+
+SourceBuffer::~SourceBuffer()
+{
+#if !WINDOWS_PLATFORM
+    if (mapped) {
+        munmap(const_cast<char *>(data), size);
+        return;
+    }
+#endif
+    delete[] data;
+}
+
+const SourceBuffer *SourceBuffer::open(const string &fileName)
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    auto iter = std::find_if(ITER_THROUGH(buffers), [&fileName](unique_ptr<SourceBuffer> &b) {
+        return b->fileName == fileName;
+    });
+    if (iter != buffers.end())
+        return iter->get();
+
+    auto buffer = unique_ptr<SourceBuffer>(new SourceBuffer(fileName, (FileID) buffers.size()));
+    if (!buffer->load())
+        return nullptr;
+    buffers.push_back(std::move(buffer));
+    return buffers.back().get();
+}
+
+const SourceBuffer &SourceBuffer::get(FileID id)
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    return *buffers[id];
+}
+
+bool SourceBuffer::load()
+{
+#if !WINDOWS_PLATFORM
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+    size = st.st_size;
+    ///mmap cannot map an empty file
+    if (size > 0) {
+        void *mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem != MAP_FAILED) {
+            data = static_cast<const char *>(mem);
+            mapped = true;
+        }
+    }
+    close(fd);
+    if (mapped || size == 0)
+        return true;
+#endif
+    std::ifstream is(fileName, std::ios::binary);
+    if (is.fail())
+        return false;
+    is.seekg(0, std::ios::end);
+    size = is.tellg();
+    is.seekg(0, std::ios::beg);
+    char *buf = new char[size];
+    is.read(buf, size);
+    data = buf;
+    return true;
+}
+
+vector<unique_ptr<SourceBuffer>> SourceBuffer::buffers = {};
+
+} // namespace kvantum::lexer
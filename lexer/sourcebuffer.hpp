@@ -0,0 +1,47 @@
+#pragma once
+
+#include "common/util.hpp"
+#include <memory>
+#include <string_view>
+
+using std::string_view;
+using std::unique_ptr;
+
+namespace kvantum::lexer {
+
+/*
+    owns the contents of a source file for the whole compilation,
+    the file is mapped into memory once and tokens refer into it with string_views
+*/
+class SourceBuffer
+{
+public:
+    using FileID = uint16_t;
+
+    ~SourceBuffer();
+    SourceBuffer(const SourceBuffer &) = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+    string_view getText() const { return {data, size}; }
+    const string &getFileName() const { return fileName; }
+    FileID getID() const { return id; }
+
+    /// maps the file or returns the already mapped buffer, returns nullptr if it cannot be opened
+    static const SourceBuffer *open(const string &fileName);
+    ///takes the lock, files can be opened concurrently
+    static const SourceBuffer &get(FileID id);
+
+private:
+    SourceBuffer(string fileName, FileID id);
+    bool load();
+
+    string fileName;
+    FileID id;
+    const char *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+
+    static vector<unique_ptr<SourceBuffer>> buffers;
+};
+
+} // namespace kvantum::lexer
@@ -1,9 +1,40 @@
 #include "common/compiler.hpp"
+#include "lexer/lexer.hpp"
 
 int main(int argc, char **argv)
 {
-    string file = argc > 1 ? argv[1] : "main.kv";
-    auto compiler = kvantum::Compiler::Instance();
+    string file = "main.kv";
+    auto &compiler = kvantum::Compiler::Instance();
+    ///--run interprets on the bytecode vm, --run-tree on the reference tree walker, --profile on the profiled tree walker
+    ///--print-c echoes the generated C to stdout, --make compiles it with the generated Makefile
+    ///--unity generates the whole program into one C file, --bench-lexer reports the lexer throughput on the file
+    enum { COMPILE, RUN, RUN_TREE, PROFILE, BENCH_LEXER } mode = COMPILE;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--run")
+            mode = RUN;
+        else if (arg == "--run-tree")
+            mode = RUN_TREE;
+        else if (arg == "--profile")
+            mode = PROFILE;
+        else if (arg == "--bench-lexer")
+            mode = BENCH_LEXER;
+        else if (arg == "--print-c")
+            compiler.setPrintGenerated(true);
+        else if (arg == "--make")
+            compiler.setRunMake(true);
+        else if (arg == "--unity")
+            compiler.setUnity(true);
+        else
+            file = arg;
+    }
+
+    if (mode == BENCH_LEXER)
+        return kvantum::lexer::Lexer::benchmark(file) ? 0 : 1;
+    if (mode == PROFILE)
+        return compiler.profile(file);
+    if (mode != COMPILE)
+        return compiler.run(file, mode == RUN_TREE);
     compiler.compile(file);
     return 0;
 }
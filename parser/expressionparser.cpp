@@ -30,20 +30,22 @@ optional<Expression *> ExpressionParser::parseExpression()
         t = getLexer().nextToken();
         if (t.type == Token::STRING) {
             ///trim the quotes
-            t.value.pop_back();
-            t.value.erase(0, 1);
+            t.value.remove_suffix(1);
+            t.value.remove_prefix(1);
         }
-        this_expr = new Literal(t.value,
-                                PrimitiveType::get(static_cast<PrimitiveType::TypeBase>(t.type)));
+        this_expr = make_node<Literal>(string(t.value),
+                                       PrimitiveType::get(
+                                           static_cast<PrimitiveType::TypeBase>(t.type)));
     } else
         switch (t.type) {
             CASE(Token::IDENTIFIER, this_expr = parseVariable(getLexer().nextToken()));
             CASE(Token::NONE,
-                 this_expr = new Literal(getLexer().nextToken().value, ObjectType::getObject()));
+                 this_expr = make_node<Literal>(string(getLexer().nextToken().value),
+                                                ObjectType::getObject()));
             CASE(Token::LSQ_BRACKET, this_expr = parseListExpression());
             CASE(Token::LESS_T, this_expr = parseArrayExpression());
             CASE(Token::AMPERSAND, getLexer().nextToken();
-                 this_expr = new TakeReference(parseExpression().value_or(nullptr)));
+                 this_expr = make_node<TakeReference>(parseExpression().value_or(nullptr)));
         default:
             expressionPanic(getLexer().nextToken());
             return {};
@@ -85,7 +87,7 @@ bool ExpressionParser::isLiteral(const kvantum::Token &t)
 
 void *ExpressionParser::expressionPanic(const Token &t)
 {
-    KVANTUM_VERIFY(isBop(t), t.value + " is not a valid expression");
+    KVANTUM_VERIFY(isBop(t), string(t.value) + " is not a valid expression");
     else panic("missing left hand side of binary operation");
     return nullptr;
 }
@@ -97,7 +99,7 @@ optional<Cast *> ExpressionParser::parseCast(Expression *base)
     if (!type.has_value())
         return {};
     KVANTUM_VERIFY_RETURN(!type.value()->isVoid(), "cannot cast to Void", {});
-    return new Cast(base, *type.value());
+    return make_node<Cast>(base, *type.value());
 }
 
 optional<ArrayIndex *> ExpressionParser::parseArrayIndex(Expression *basearr)
@@ -107,7 +109,7 @@ optional<ArrayIndex *> ExpressionParser::parseArrayIndex(Expression *basearr)
     if (!ind.has_value())
         return {};
     getLexer().nextToken().as(Token::RSQ_BRACKET); // Assuming lexer is a member pointer
-    return new ArrayIndex(basearr, ind.value());
+    return make_node<ArrayIndex>(basearr, ind.value());
 }
 
 optional<BinaryOperation *> ExpressionParser::parseBop(optional<Expression *> lhs)
@@ -131,7 +133,7 @@ optional<BinaryOperation *> ExpressionParser::parseBop(optional<Expression *> lh
                                   Token::OR};
     BinaryOperation::Operator op = (BinaryOperation::Operator)
         std::distance(bops.begin(), std::find(ITER_THROUGH(bops), t.type));
-    return new BinaryOperation(lhs.value(), rhs.value(), op);
+    return make_node<BinaryOperation>(lhs.value(), rhs.value(), op);
 }
 
 optional<FunctionCall *> ExpressionParser::parseListExpression()
@@ -143,22 +145,24 @@ optional<FunctionCall *> ExpressionParser::parseListExpression()
     auto init = parseArrayInitializer(
         Token::LSQ_BRACKET,
         Token::RSQ_BRACKET); // This call was inside the pushLexer block, moved outside based on typical scope handling. Revert if original logic is intended.
-    Type &t = Type::get("Void");
+    Type *itemType = &Type::get("Void");
     if (!init.empty())
-        t = init[0]->getType();
+        itemType = &init[0]->getType();
+    Type &t = *itemType;
 
     ///if its the first time a list with the specifie type has beed initiated add to the type pool
-    if (!getWorkModule().hasType(ListType::get(t).getName()))
-        getWorkModule().addObjectType(&ListType::get(t));
+    if (!getWorkModule().hasType(ListType::get(t).getSymbol()))
+        getWorkModule().addSharedType(ListType::get(t));
 
     popLexer(); // Pop after processing the scope
 
     ///pack the arrayexpression into a [].new call and provide the array body and size as arguments
-    return new FunctionCall(new FieldAccess(new Variable("[]", ListType::get(t)),
-                                            new Variable("new")),
-                            {new ArrayExpression(t, init),
-                             new Literal(std::to_string(init.size()), Type::get("Int"))},
-                            ListType::get(t).getFunction("new"));
+    return make_node<FunctionCall>(
+        make_node<FieldAccess>(make_node<Variable>("[]", ListType::get(t)),
+                               make_node<Variable>("new")),
+        vector<Expression *>{make_node<ArrayExpression>(t, init),
+                             make_node<Literal>(std::to_string(init.size()), Type::get("Int"))},
+        ListType::get(t).getFunction("new"));
 }
 
 vector<Literal *> ExpressionParser::parseArrayInitializer(Token::TokenType beg, Token::TokenType end)
@@ -196,7 +200,7 @@ optional<ArrayExpression *> ExpressionParser::parseArrayExpression()
     if (!init.empty())
         t = &init[0]->getType();
 
-    return new ArrayExpression(*t, init);
+    return make_node<ArrayExpression>(*t, init);
 }
 
 Expression *ExpressionParser::toPrefixForm(Expression *infix) const {}
@@ -8,6 +8,7 @@ FunctionDefParser::FunctionDefParser(Lexer &lexer,
                                      Module &workMod,
                                      vector<Annotation *> &annotations)
     : Parser(workMod)
+    , annotations(annotations)
 {
     pushLexer(lexer);
 }
@@ -20,11 +21,11 @@ Variable *FunctionDefParser::parseFunctionIdentifier()
         auto base = var->as<FieldAccess *>()->base->as<Variable *>();
         if (var->as<FieldAccess *>()->field->id == "new")
             node->setTrait(FunctionNode::STATIC);
-        KVANTUM_VERIFY(getWorkModule().hasType(base->id), "no type named " + base->id);
+        KVANTUM_VERIFY(getWorkModule().hasType(base->symbol), "no type named " + base->id);
         else
         {
-            base->setType(getWorkModule().getType(base->id));
-            node->makeMethod(getWorkModule().getType(base->id));
+            base->setType(getWorkModule().getType(base->symbol));
+            node->makeMethod(getWorkModule().getType(base->symbol));
         }
     }
     return var;
@@ -34,12 +35,16 @@ unique_ptr<FunctionNode> FunctionDefParser::parseFunctionDefinition()
 {
     getLexer().nextToken().as(Token::FUNCTION);
     Variable *id = parseFunctionIdentifier();
+    ///annotations preceding the definition belong to it
+    if (!annotations.empty())
+        node->setAnnotation(annotations.back());
+    annotations.clear();
 
     /* TODO implement functional */
     if (false)
         parseFunctional(node.get());
     else {
-        parseFormalParams(node->formalParams);
+        parseFormalParams(node.get());
         if (getLexer().lookAhead().type == Token::DUAL_ARROW)
             parseConstant(node.get());
         else
@@ -48,7 +53,7 @@ unique_ptr<FunctionNode> FunctionDefParser::parseFunctionDefinition()
     return std::move(node);
 }
 
-void FunctionDefParser::parseFormalParams(vector<Variable *> &params)
+void FunctionDefParser::parseFormalParams(FunctionNode *node)
 {
     auto scope = Scope::nextScope(getLexer(), Token::L_BRACKET, Token::R_BRACKET);
     if (!scope.has_value())
@@ -65,7 +70,7 @@ void FunctionDefParser::parseFormalParams(vector<Variable *> &params)
             auto typeOpt = parseTypeName();
             auto type = typeOpt.value_or(&Type::get("Void"));
             KVANTUM_VERIFY(*type != Type::get("Void"), "parameter cannot have Void type");
-            params.push_back(new Variable(name.value, *type));
+            node->addParameter(make_node<Variable>(name.symbol, *type));
 
             if (getLexer().lookAhead().type == Token::COMMA)
                 t = getLexer().nextToken();
@@ -86,10 +91,11 @@ void FunctionDefParser::parseFunctional(FunctionNode *node) {}
 void FunctionDefParser::parseConstant(FunctionNode *node)
 {
     getLexer().nextToken().as(Token::DUAL_ARROW);
+    node->setTrait(FunctionNode::EXPRESSION);
     ExpressionParser expParser(getLexer(), getWorkModule());
     auto exp = expParser.parseExpression();
     getLexer().skipUntil({Token::SEMI_COLON});
-    node->ast.push_back(new Return(exp.value_or(nullptr)));
+    node->ast.push_back(make_node<Return>(exp.value_or(nullptr)));
 }
 
 void FunctionDefParser::parseNormal(FunctionNode *node)
@@ -131,8 +137,10 @@ void FunctionDefParser::setTraitList(FunctionNode *node)
     try {
         getLexer().nextToken();
         while (!getLexer().end() && getLexer().lookAhead().type != Token::RSQ_BRACKET) {
-            Token next = getLexer().nextToken().as(Token::IDENTIFIER);
-            if (next.value == "public")
+            Token next = getLexer().nextToken();
+            if (next.type == Token::EXTERN)
+                node->setTrait(FunctionNode::EXTERNAL);
+            else if (next.as(Token::IDENTIFIER).value == "public")
                 node->setTrait(FunctionNode::PUBLIC);
             else if (next.value == "const")
                 node->setTrait(FunctionNode::CONST);
@@ -143,7 +151,7 @@ void FunctionDefParser::setTraitList(FunctionNode *node)
             else if (next.value == "override")
                 node->setTrait(FunctionNode::OVERRIDE);
             else
-                panic("unknown trait " + next.value);
+                panic("unknown trait " + string(next.value));
 
             if (!getLexer().end() && getLexer().lookAhead().type == Token::COMMA)
                 getLexer().nextToken();
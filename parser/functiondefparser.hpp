@@ -5,17 +5,18 @@ namespace kvantum::parser {
 class FunctionDefParser : public Parser
 {
 public:
-    FunctionDefParser(Lexer &lexer, Module &workMod, vector<Annotation *> &annotations = {});
+    FunctionDefParser(Lexer &lexer, Module &workMod, vector<Annotation *> &annotations);
     unique_ptr<FunctionNode> parseFunctionDefinition();
 
 private:
     Variable *parseFunctionIdentifier();
-    void parseFormalParams(vector<Variable *> &params);
+    void parseFormalParams(FunctionNode *node);
     void parseFunctional(FunctionNode *);
     void parseConstant(FunctionNode *);
     void parseNormal(FunctionNode *);
     void setTraitList(FunctionNode *node);
 
     unique_ptr<FunctionNode> node;
+    vector<Annotation *> &annotations;
 };
 } // namespace kvantum::parser
@@ -5,24 +5,34 @@
 namespace kvantum::parser {
 
 ModuleParser::ModuleParser(const string& fileName)
-    : Parser(*new Module(fileName))
+    : Parser(*new Module(Module::nameOf(fileName), fileName))
+    , fileName(fileName)
 {
     workModule = unique_ptr<Module>(&getWorkModule());
 }
 
-unique_ptr<Module> ModuleParser::parse() {}
+unique_ptr<Module> ModuleParser::parse()
+{
+    Lexer lexer(fileName);
+    if (lexer.hasError())
+        return std::move(workModule);
+    pushLexer(lexer);
+    parseFile();
+    popLexer();
+    return std::move(workModule);
+}
 
 void ModuleParser::addFunction(unique_ptr<FunctionNode> func)
 {
     auto id = func->getFunctionID();
     if (id.isField()) {
-        auto obj = getWorkModule().getObject(id.parentObj);
-        obj.addFunction(id.name, std::move(func));
+        auto& obj = getWorkModule().getObject(id.parentObj);
+        obj.addFunction(id.name, func.get());
     }
     getWorkModule().addFunction(std::move(func));
 }
 
-void ModuleParser::parseFile(Lexer* lexer)
+void ModuleParser::parseFile()
 {
     vector<Annotation*> annotations;
     try {
@@ -36,13 +46,14 @@ void ModuleParser::parseFile(Lexer* lexer)
                 parseExternalDependency();
             else if (t.type == Token::ANNOTATION) {
                 t = getLexer().nextToken();
-                KVANTUM_VERIFY(Annotation::isValid(t.value), "no valid annotation " + t.value);
+                string annotation(t.value);
+                KVANTUM_VERIFY(Annotation::isValid(annotation), "no valid annotation " + annotation);
                 else
                 {
-                    annotations.push_back(Annotation::getAnnotation(t.value));
+                    annotations.push_back(Annotation::getAnnotation(annotation));
                 }
             } else {
-                Diagnostics::warn("Unexprected token :" + getLexer().nextToken().value);
+                Diagnostics::warn("Unexprected token :" + string(getLexer().nextToken().value));
             }
         }
     } catch (Lexer::UnexpectedEndOfTokens&) {
@@ -53,15 +64,14 @@ void ModuleParser::parseFile(Lexer* lexer)
 void ModuleParser::parseFunctionDefinition(vector<Annotation*>& annotations)
 {
     FunctionDefParser fparser(getLexer(), getWorkModule(), annotations);
-    auto func = fparser.parseFunctionDecl();
-    addFunction(func);
+    addFunction(fparser.parseFunctionDefinition());
 }
 
 void ModuleParser::parseTypeDefinition(vector<Annotation*>& annotations)
 {
     getLexer().nextToken().as(Token::TYPE);
     Token id = getLexer().nextToken().as(Token::IDENTIFIER);
-    TypeNode* node = new TypeNode(id.value);
+    TypeNode* node = new TypeNode(string(id.value));
 
     ///type inheritance
     optional<Type*> parentT = {};
@@ -75,20 +85,21 @@ void ModuleParser::parseTypeDefinition(vector<Annotation*>& annotations)
     }
     getLexer().nextToken().as(Token::LC_BRACKET);
 
-    getWorkModule().addObjectType(
-        new ObjectType(node, parentT.has_value() ? (ObjectType*) &parentT.value() : nullptr));
+    getWorkModule().addObjectType(std::make_unique<ObjectType>(
+        node, parentT.has_value() ? (ObjectType*) parentT.value() : nullptr));
 
     ///parse the type body
     while (getLexer().lookAhead().type != Token::RC_BRACKET) {
         Token fieldId = getLexer().nextToken().as(Token::IDENTIFIER);
         getLexer().nextToken().as(Token::COLON);
-        if (node->fields.count(fieldId.value))
-            panic(id.value + " already has a field named " + fieldId.value);
+        string field(fieldId.value);
+        if (node->fields.count(field))
+            panic(node->name + " already has a field named " + field);
         else {
             auto templt = parseTypeName();
             KVANTUM_VERIFY(*templt.value_or(&Type::get("Void")) != Type::get("Void"),
                            "field cannot be declared with Void value");
-            node->fields.emplace(fieldId.value, templt.value_or(&Type::get("Void")));
+            node->fields.emplace(field, templt.value_or(&Type::get("Void")));
             if (!templt.has_value())
                 getLexer().skipUntil({Token::SEMI_COLON});
         }
@@ -102,14 +113,18 @@ void ModuleParser::parseExternalDependency()
 {
     getLexer().nextToken().as(Token::USE);
     KVANTUM_VERIFY_ABANDON(!getLexer().end(), "invalid use directive");
-    auto mod = getLexer().nextToken().value;
+    string mod(getLexer().nextToken().value);
     KVANTUM_VERIFY_ABANDON(!getLexer().end(), "invalid use directive");
     getLexer().nextToken().as(Token::NAMESPACE_SCOPE);
     KVANTUM_VERIFY_ABANDON(!getLexer().end(), "invalid use directive");
-    auto item = getLexer().nextToken().value;
+    string item(getLexer().nextToken().value);
     KVANTUM_VERIFY(getLexer().consumeIf(Token::SEMI_COLON).has_value(),
                    "semi colon missing after use directive");
 
+    ///imported modules are looked up next to the importing file
+    if (!Compiler::Instance().requireModule(mod, Module::directoryOf(fileName) + mod + ".kv"))
+        return;
+
     if (Compiler::Instance().hasFunction(mod, item))
         getWorkModule().addExternalFunctionDependency(mod, item);
     else if (Compiler::Instance().hasObject(mod, item))
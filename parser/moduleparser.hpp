@@ -15,11 +15,12 @@ public:
 private:
     void parseFunctionDefinition(vector<Annotation*>& annotations);
     void parseTypeDefinition(vector<Annotation*>& annotations);
-    void parseFile(Lexer* lexer);
+    void parseFile();
     void parseExternalDependency();
     void addFunction(unique_ptr<FunctionNode> func);
 
     unique_ptr<Module> workModule;
+    string fileName;
 };
 
 } // namespace kvantum::parser
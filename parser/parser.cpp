@@ -6,8 +6,12 @@ namespace kvantum::parser {
 
 Parser::Parser(Module& workMod)
     : workModule(&workMod)
+    , arenaActivation(workMod.getArena())
+    , diagnosticsActivation(workMod.getDiagnostics())
 {}
 
+Parser::~Parser() = default;
+
 optional<Type*> Parser::parseTypeName()
 {
     if (getLexer().lookAhead().type == Token::LSQ_BRACKET) {
@@ -33,11 +37,11 @@ optional<Type*> Parser::parseTypeName()
     }
 
     auto tok = getLexer().nextToken().as(Token::IDENTIFIER);
-    if (!getWorkModule().hasType(tok.value)) {
-        panic("no type named " + tok.value);
+    if (!getWorkModule().hasType(tok.symbol)) {
+        panic("no type named " + string(tok.value));
         return {};
     }
-    Type* type = &getWorkModule().getType(tok.value);
+    Type* type = &getWorkModule().getType(tok.symbol);
 
     if (isRef)
         return &ReferenceType::get(*type);
@@ -58,7 +62,7 @@ Statement* Parser::parseStatement()
             CASE(Token::IF, valid = parseIf());
             CASE(Token::WHILE, valid = parseWhile());
             CASE(Token::LC_BRACKET, valid = parseStatementBlock());
-            CASE(Token::END_OF_FILE, valid = new StatementBlock());
+            CASE(Token::END_OF_FILE, valid = make_node<StatementBlock>());
         default:
             errq.push(token);
             break;
@@ -78,7 +82,7 @@ Statement* Parser::parseStatement()
 
 StatementBlock* Parser::parseStatementBlock()
 {
-    StatementBlock* block = new StatementBlock();
+    StatementBlock* block = make_node<StatementBlock>();
     while (!getLexer().end() && getLexer().lookAhead().type != Token::RC_BRACKET) {
         Statement* st = parseStatement();
         if (st)
@@ -110,7 +114,7 @@ Assigment* Parser::parseAssigment(Variable* var)
         panic("no semi colon at the end of assignment");
 
     var->setType(*assignTy);
-    return new Assigment(var, expr.value());
+    return make_node<Assigment>(var, expr.value());
 }
 
 Statement* Parser::parseAssigment_Fcall(Variable* var)
@@ -132,7 +136,7 @@ While* Parser::parseWhile()
     auto exp = parseExpression();
     if (!exp.has_value())
         getLexer().skipUntil({Token::L_BRACKET});
-    While* wh = new While(exp.value_or(nullptr));
+    While* wh = make_node<While>(exp.value_or(nullptr));
     if (!getLexer().consumeIf(Token::COLON).has_value())
         panic("no colon for while statement");
     wh->block = parseStatement();
@@ -145,7 +149,7 @@ If_Else* Parser::parseIf()
     if (!exp.has_value())
         getLexer().skipUntil({Token::L_BRACKET});
 
-    If_Else* ife = new If_Else(exp.value_or(nullptr));
+    If_Else* ife = make_node<If_Else>(exp.value_or(nullptr));
     if (!getLexer().consumeIf(Token::COLON).has_value())
         panic("no colon for if statement");
 
@@ -168,7 +172,7 @@ Return* Parser::parseReturn()
         getLexer().skipUntil({Token::SEMI_COLON});
     if (!getLexer().consumeIf(Token::SEMI_COLON).has_value())
         panic("no semi colon at the end of assignment");
-    return new Return(exp.value_or(nullptr));
+    return make_node<Return>(exp.value_or(nullptr));
 }
 
 /*
@@ -183,7 +187,9 @@ Return* Parser::parseReturn()
     */
 Variable* Parser::parseVariable(const Token& idToken)
 {
-    Variable* var = new Variable(idToken.value);
+    Variable* var = idToken.symbol != SymbolTable::NO_SYMBOL
+                        ? make_node<Variable>(idToken.symbol)
+                        : make_node<Variable>(string(idToken.value));
     if (getLexer().lookAhead().type != Token::DOT)
         return var;
 
@@ -198,7 +204,7 @@ optional<FieldAccess*> Parser::parseFieldAccess(Expression* var)
 {
     getLexer().nextToken().as(Token::DOT);
     if (!getLexer().end() && getLexer().lookAhead().type == Token::IDENTIFIER)
-        return new FieldAccess(var, parseVariable(getLexer().nextToken()));
+        return make_node<FieldAccess>(var, parseVariable(getLexer().nextToken()));
     panic("no identifier after .");
     return {};
 }
@@ -208,7 +214,7 @@ optional<FunctionCall*> Parser::parseFunctionCall(Expression* var)
     KVANTUM_VERIFY_RETURN(var && var->exprtype == ExprType::VARIABLE,
                           "invalid function identifier",
                           {});
-    auto* call = new FunctionCall(var->as<Variable*>(), {});
+    auto* call = make_node<FunctionCall>(var->as<Variable*>());
     parseArguments(call->arguments);
 
     return call;
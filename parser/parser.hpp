@@ -48,7 +48,7 @@ namespace kvantum::parser
         optional<FunctionCall*> parseFunctionCall(Expression* var);
         void parseArguments(vector<Expression*>& args);
 
-        Lexer& getLexer() const { return *lexers.front(); }
+        Lexer& getLexer() const { return *lexers.top(); }
         void pushLexer(Lexer& lexer) { lexers.push(&lexer); }
         void popLexer() { lexers.pop(); }
 
@@ -57,7 +57,10 @@ namespace kvantum::parser
     private:
         optional<Expression*> parseExpression();
 
-        queue<Lexer*> lexers;
+        std::stack<Lexer*> lexers;
         Module* workModule;
+        ///nodes created and errors reported while parsing belong to the work module
+        AstArena::Activation arenaActivation;
+        DiagnosticContext::Activation diagnosticsActivation;
     };
 }
@@ -3,62 +3,76 @@
 #include "ast/ast.hpp"
 #include "common/module.hpp"
 #include <stack>
+#include <unordered_map>
 
 using kvantum::Type;
 using std::pair;
 namespace kvantum::parser
 {
+    /*
+        scoped symbol table, every name maps to the index of its innermost declaration
+        and each entry remembers the declaration it shadows, so lookups are a single hash probe
+    */
     template<typename T>
     class SymbolStack
     {
     public:
         SymbolStack();
-        bool isDeclared(string name);
-        bool isDeclaredLocal(string name);
-        T get(string name);
-        pair <string, T> &getNode(string name);
+        bool isDeclared(SymbolID name);
+        bool isDeclared(const string &name) { return isDeclared(SymbolTable::intern(name)); }
+        bool isDeclaredLocal(SymbolID name);
+        bool isDeclaredLocal(const string &name) { return isDeclaredLocal(SymbolTable::intern(name)); }
+        T get(SymbolID name);
+        T get(const string &name) { return get(SymbolTable::intern(name)); }
+        pair<SymbolID, T> &getNode(SymbolID name);
+        pair<SymbolID, T> &getNode(const string &name) { return getNode(SymbolTable::intern(name)); }
 
         void popSegment();
-        void pushSegment(vector <pair<string, T>> vars);
-        void push(pair <string, T> val);
+        void pushSegment() { segmentPtr.push((unsigned short)stack.size()); }
+        void pushSegment(vector<pair<string, T>> vars);
+        void pushSegment(const vector<pair<SymbolID, T>> &vars);
+        void push(pair<SymbolID, T> val);
+        void push(pair<string, T> val) { push({SymbolTable::intern(val.first), val.second}); }
     private:
-        typename vector<pair<string,T>>::iterator search(string name);
+        static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+        uint32_t search(SymbolID name);
 
-        vector <pair<string, T>> stack;
-        typename vector<pair<string,T>>::iterator lastFound;
+        vector<pair<SymbolID, T>> stack;
+        ///index of the declaration hidden by the entry at the same position
+        vector<uint32_t> shadowed;
+        std::unordered_map<SymbolID, uint32_t> innermost;
         std::stack<uint16_t> segmentPtr;
     };
 
     template<typename T>
     SymbolStack<T>::SymbolStack()
     {
-        lastFound = stack.end();
         segmentPtr.push(0);
     }
 
     template<typename T>
-    bool SymbolStack<T>::isDeclared(string name)
+    bool SymbolStack<T>::isDeclared(SymbolID name)
     {
-        return search(name) != stack.end();
+        return search(name) != NOT_FOUND;
     }
 
     template<typename T>
-    bool SymbolStack<T>::isDeclaredLocal(std::string name)
+    bool SymbolStack<T>::isDeclaredLocal(SymbolID name)
     {
-        auto loc = this->search(name);
-        return loc != stack.end() && (std::distance(stack.begin(), loc) >= segmentPtr.top());
+        auto loc = search(name);
+        return loc != NOT_FOUND && loc >= segmentPtr.top();
     }
 
     template<typename T>
-    T SymbolStack<T>::get(string name)
+    T SymbolStack<T>::get(SymbolID name)
     {
-        return search(name)->second;
+        return stack[search(name)].second;
     }
 
     template<typename T>
-    pair <string, T> &SymbolStack<T>::getNode(string name)
+    pair<SymbolID, T> &SymbolStack<T>::getNode(SymbolID name)
     {
-        return *search(name);
+        return stack[search(name)];
     }
 
     template<typename T>
@@ -69,41 +83,49 @@ namespace kvantum::parser
             ptr = segmentPtr.top();
             segmentPtr.pop();
         }
+        ///restore the declarations hidden by the popped ones
+        for (size_t i = stack.size(); i > ptr; i--) {
+            if (shadowed[i - 1] == NOT_FOUND)
+                innermost.erase(stack[i - 1].first);
+            else
+                innermost[stack[i - 1].first] = shadowed[i - 1];
+        }
         stack.resize(ptr);
-        lastFound = stack.end();
+        shadowed.resize(ptr);
     }
 
     template<typename T>
-    void SymbolStack<T>::pushSegment(vector<pair < string, T>> vars)
+    void SymbolStack<T>::pushSegment(vector<pair<string, T>> vars)
     {
         ///save the current stack size
-        segmentPtr.push((unsigned short)stack.size());
+        pushSegment();
 
-        stack.insert(stack.end(), ITER_THROUGH(vars));
-        lastFound = stack.end();
+        for (auto &e : vars)
+            push(e);
     }
 
-template<typename T>
-void SymbolStack<T>::push(pair<string, T> val)
-{
-    stack.push_back(val);
-    lastFound = stack.end();
-}
+    template<typename T>
+    void SymbolStack<T>::pushSegment(const vector<pair<SymbolID, T>> &vars)
+    {
+        pushSegment();
 
-template<typename T>
-typename vector<pair<string,T>>::iterator SymbolStack<T>::search(string name)
-{
-    if (lastFound != stack.end() && lastFound->first == name)
-        return lastFound;
-    lastFound = stack.end();
-    if(stack.empty())
-        return lastFound;
-    for(auto iter = std::prev(stack.end());iter >= stack.begin();iter--){
-        if (iter->first == name){
-            lastFound = iter;
-            return lastFound;
-        }
+        for (auto &e : vars)
+            push(e);
+    }
+
+    template<typename T>
+    void SymbolStack<T>::push(pair<SymbolID, T> val)
+    {
+        auto iter = innermost.find(val.first);
+        shadowed.push_back(iter != innermost.end() ? iter->second : NOT_FOUND);
+        innermost[val.first] = (uint32_t) stack.size();
+        stack.push_back(val);
+    }
+
+    template<typename T>
+    uint32_t SymbolStack<T>::search(SymbolID name)
+    {
+        auto iter = innermost.find(name);
+        return iter != innermost.end() ? iter->second : NOT_FOUND;
     }
-    return lastFound;
 }
-}
\ No newline at end of file
@@ -8,6 +8,8 @@ TypeChecker::TypeChecker()
 
 void TypeChecker::checkModule(Module *mod)
 {
+    AstArena::Activation arena(mod->getArena());
+    DiagnosticContext::Activation diagnostics(mod->getDiagnostics());
     Diagnostics::log("module " + mod->getName() + " is being checked\n");
     this->mod = mod;
     auto objt = mod->getObjectTypes();
@@ -27,15 +29,17 @@ void TypeChecker::checkModule(Module *mod)
 void TypeChecker::checkFunction(FunctionNode *node)
 {
     functionCheckStack.push(node);
-    if (checkedFunctions.count(node) > 0 || node->hasAnnotation(Annotation::Native)) {
+    ///imported functions are checked by their own module, which is done before this one starts
+    if (checkedFunctions.count(node) > 0 || node->hasAnnotation(Annotation::Native)
+        || mod->isExternalFunction(node)) {
         functionCheckStack.pop();
         return;
     }
     checkedFunctions.insert(node);
     Diagnostics::log("func " + node->getName() + " is being checked\n");
-    symbols.pushSegment({});
+    symbols.pushSegment();
     for (auto &e : node->formalParams) {
-        symbols.push({e->id, &e->getType()});
+        symbols.push({e->symbol, &e->getType()});
     }
 
     for (int i = 0; i < node->ast.size(); i++) {
@@ -67,7 +71,7 @@ any TypeChecker::visit(BinaryOperation *bop)
     auto &l = visitExpression(bop->lhs);
     auto &r = visitExpression(bop->rhs);
     if (bop->isBool())
-        return &PrimitiveType::get(PrimitiveType::Boolean);
+        return (Type *) &PrimitiveType::get(PrimitiveType::Boolean);
     KVANTUM_VERIFY(l == r, "binary operand types mismatch: " + l.getName() + " " + r.getName());
     return &l;
 }
@@ -123,10 +127,10 @@ void TypeChecker::visit(Assigment *assig)
     auto &value = visitExpression(assig->expr);
 
     KVANTUM_VERIFY(assig->variable->isField() || assig->isDeclaration()
-                       || symbols.isDeclared(assig->variable->id),
+                       || symbols.isDeclared(assig->variable->symbol),
                    "variable not declared " + assig->variable->id);
     KVANTUM_VERIFY(assig->variable->isField() || !assig->isDeclaration()
-                       || !symbols.isDeclaredLocal(assig->variable->id),
+                       || !symbols.isDeclaredLocal(assig->variable->symbol),
                    "redeclaration of local variable " + assig->variable->id);
     KVANTUM_VERIFY(assig->variable->getType().isVoid() || assig->variable->getType() == value,
                    "expression type " + value.getName() + " does not equal specified type "
@@ -142,7 +146,11 @@ void TypeChecker::visit(If_Else *if_else)
         visit_statement(if_else->elseBlock);
 }
 
-void TypeChecker::visit(While *while_loop) {}
+void TypeChecker::visit(While *while_loop)
+{
+    visit_expression(while_loop->condition);
+    visit_statement(while_loop->block);
+}
 void TypeChecker::visit(For *for_loop) {}
 
 void TypeChecker::visit(Return *ret)
@@ -176,6 +184,13 @@ any TypeChecker::visit(FunctionCall *fcall)
         KVANTUM_VERIFY_ERROR(symbols.isDeclared(identifier.parentObj),
                              "no object declared " + identifier.parentObj);
         identifier.setBaseType(*symbols.get(identifier.parentObj));
+        ///type names are declared as themselves and call static methods, objects are the first parameter
+        bool typeName = mod->hasType(identifier.parentObj)
+                        && &mod->getType(identifier.parentObj) == symbols.get(identifier.parentObj);
+        if (!typeName) {
+            visitExpression(fcall->var->as<FieldAccess *>()->base);
+            identifier.params.insert(identifier.params.begin(), &identifier.getBaseType());
+        }
     }
 
     KVANTUM_VERIFY_ERROR(mod->hasFunction(identifier),
@@ -184,11 +199,9 @@ any TypeChecker::visit(FunctionCall *fcall)
     fcall->setNode(mod->getFunction(identifier));
     checkFunction(fcall->fnode);
 
-    /// if its a non static method push self as first argument
+    /// if its a non static method push the receiver as the self argument
     if (!fcall->fnode->hasTrait(FunctionNode::STATIC) && fcall->var->isField())
-        fcall->arguments.insert(fcall->arguments.begin(),
-                                new Variable("self",
-                                             fcall->var->as<FieldAccess *>()->base->getType()));
+        fcall->arguments.insert(fcall->arguments.begin(), fcall->var->as<FieldAccess *>()->base);
 
     /// verify the arguments size an type order
     KVANTUM_VERIFY(fcall->fnode->formalParams.size() == fcall->arguments.size(),
@@ -199,7 +212,7 @@ any TypeChecker::visit(FunctionCall *fcall)
     for (int i = 0; i < std::min(fcall->fnode->formalParams.size(), fcall->arguments.size()); i++) {
         auto &e = fcall->arguments[i];
         auto &param = fcall->fnode->formalParams[i];
-        KVANTUM_VERIFY(e->getType() == param->getType(),
+        KVANTUM_VERIFY(e->getType().isAssignableTo(param->getType()),
                        e->getType().getName() + " does not equal expected "
                            + param->getType().getName());
     }
@@ -219,15 +232,15 @@ Type &TypeChecker::getType(Expression *expr)
 
 Type &TypeChecker::getVariableType(Variable *var)
 {
-    if (symbols.isDeclared(var->id))
-        return *symbols.get(var->id);
+    if (symbols.isDeclared(var->symbol))
+        return *symbols.get(var->symbol);
     panic(var->id + " not declared");
     return KVANTUM_TYPE_ERROR;
 }
 
 void TypeChecker::setVariableType(Variable *var, Type &t)
 {
-    symbols.push({var->id, &t});
+    symbols.push({var->symbol, &t});
     var->setType(t);
 }
 
@@ -247,7 +260,7 @@ Type &TypeChecker::handleVariable(Variable *var, bool assig)
     if (assig)
         return KVANTUM_TYPE_ERROR;
     if (var->getType() == PrimitiveType::get(PrimitiveType::Void)) {
-        KVANTUM_VERIFY_RETURN(symbols.isDeclared(var->id),
+        KVANTUM_VERIFY_RETURN(symbols.isDeclared(var->symbol),
                               "variable not declared " + var->id,
                               KVANTUM_TYPE_ERROR);
         var->setType(getVariableType(var));